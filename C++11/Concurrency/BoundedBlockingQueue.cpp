@@ -0,0 +1,74 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BoundedBlockingQueue.hpp"
+
+// Producers and consumers hand 'items' ints through a small queue; returns
+// items per second and how often someone had to park.
+static double handoff_rate(unsigned spin_loops, int pairs, int items, uint64_t& parks) {
+    BoundedBlockingQueue<int> q(256, spin_loops);
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int p = 0; p < pairs; ++p) {
+        threads.emplace_back([&, p] {
+            for (int i = p; i < items; i += pairs) q.push(i);
+        });
+        threads.emplace_back([&] {
+            int v;
+            while (q.pop(v) == QueueStatus::Ok) {}
+        });
+    }
+    for (int p = 0; p < pairs; ++p) threads[2 * p].join();
+    q.close();
+    for (int p = 0; p < pairs; ++p) threads[2 * p + 1].join();
+    std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+    parks = q.parks();
+    return items / secs.count();
+}
+
+int main() {
+    // Three-stage pipeline: numbers -> squares -> printer; close() flows
+    // downstream once each stage has drained its input.
+    BoundedBlockingQueue<int> numbers(4);
+    BoundedBlockingQueue<std::string> squares(4);
+
+    std::thread source([&] {
+        for (int i = 1; i <= 8; ++i) numbers.push(i);
+        numbers.close();
+    });
+    std::thread square([&] {
+        int n;
+        while (numbers.pop(n) == QueueStatus::Ok)
+            squares.push(std::to_string(n) + "^2=" + std::to_string(n * n));
+        squares.close();
+    });
+    std::string line;
+    while (squares.pop(line) == QueueStatus::Ok) std::cout << line << "\n";
+    source.join();
+    square.join();
+    std::cout << "after close push: " << to_string(numbers.try_push(9)) << "\n";
+
+    // Timed waits on a full and on an empty queue.
+    BoundedBlockingQueue<int> small(2);
+    small.push(1);
+    small.push(2);
+    std::cout << "push_wait_for on full: "
+              << to_string(small.push_wait_for(3, std::chrono::milliseconds(5))) << "\n";
+    int v;
+    small.pop(v);
+    small.pop(v);
+    std::cout << "pop_wait_for on empty: "
+              << to_string(small.pop_wait_for(v, std::chrono::milliseconds(5))) << "\n";
+
+    for (int pairs : {1, 4}) {
+        for (unsigned spin : {0u, 128u}) {
+            uint64_t parks;
+            double rate = handoff_rate(spin, pairs, 1000000, parks);
+            std::cout << pairs << " producer/consumer pairs, spin_loops=" << spin << ": "
+                      << rate / 1e6 << "M items/s, " << parks << " parks\n";
+        }
+    }
+}
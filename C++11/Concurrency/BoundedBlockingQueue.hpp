@@ -0,0 +1,275 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "SpinWait.hpp"
+
+// -------------------- Bounded blocking queue (channel) --------------------
+// Fixed-capacity MPMC queue for connecting pipeline stages: the ring is
+// allocated once, so memory stays put however far a consumer falls behind.
+//
+//   try_push / try_pop          never block (Full / Empty)
+//   push / pop                  block until done or the queue is closed
+//   push_wait_for / pop_wait_for  block at most 'timeout' (Timeout)
+//
+// The ring is Vyukov's bounded MPMC array. A blocked caller first retries
+// spin_loops times with cpu_relax(), then parks on a futex; the other side
+// only makes a syscall when its fenced waiter count says someone is parked,
+// so an uncontended handoff costs no syscall at all.
+//
+// close() stops further pushes (they return Closed, and parked producers
+// wake up), while consumers keep popping what was accepted before the close
+// and only then get Closed. The closed bit lives in the tail cursor, so a
+// push either claims a slot before the close, and is drained, or fails.
+//
+// T must be nothrow move-constructible. Pushed values are constructed in
+// place once a slot is claimed, so a Full or Closed push never touches its
+// argument. If that construction throws (a copy, or a conversion from
+// another type), the slot is published as a hole that consumers skip and
+// the exception propagates.
+
+enum class QueueStatus { Ok, Empty, Full, Timeout, Closed };
+
+inline const char* to_string(QueueStatus s) noexcept {
+    switch (s) {
+    case QueueStatus::Ok:      return "ok";
+    case QueueStatus::Empty:   return "empty";
+    case QueueStatus::Full:    return "full";
+    case QueueStatus::Timeout: return "timeout";
+    case QueueStatus::Closed:  return "closed";
+    }
+    return "?";
+}
+
+template <class T>
+class BoundedBlockingQueue {
+    static_assert(std::is_nothrow_move_constructible<T>::value,
+                  "BoundedBlockingQueue needs a nothrow move constructor");
+
+public:
+    // 'capacity' is rounded up to a power of two.
+    explicit BoundedBlockingQueue(size_t capacity, unsigned spin_loops = 128)
+    : capacity_(round_up_pow2(capacity)), mask_(capacity_ - 1), spin_loops_(spin_loops),
+      cells_(new Cell[capacity_]) {
+        for (size_t i = 0; i < capacity_; ++i) cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    BoundedBlockingQueue(const BoundedBlockingQueue&) = delete;
+    BoundedBlockingQueue& operator=(const BoundedBlockingQueue&) = delete;
+
+    ~BoundedBlockingQueue() {
+        uint64_t end = tail_.load(std::memory_order_relaxed) & ~kClosed;
+        for (uint64_t i = head_.load(std::memory_order_relaxed); i != end; ++i)
+            if (!cells_[i & mask_].hole) cells_[i & mask_].value()->~T();
+        delete[] cells_;
+    }
+
+    // Ok, Full or Closed; 'v' is only moved from on Ok.
+    template <class U>
+    QueueStatus try_push(U&& v) {
+        uint64_t pos = tail_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            if (pos & kClosed) return QueueStatus::Closed;
+            cell = &cells_[pos & mask_];
+            uint64_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if (dif == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (dif < 0) {
+                return QueueStatus::Full;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        if constexpr (std::is_nothrow_constructible<T, U&&>::value) {
+            new (cell->storage) T(std::forward<U>(v));
+        } else {
+            try {
+                new (cell->storage) T(std::forward<U>(v));
+            } catch (...) {
+                // The slot is ours and can't be given back; publish a hole.
+                cell->hole = true;
+                cell->seq.store(pos + 1, std::memory_order_release);
+                wake(not_empty_);
+                throw;
+            }
+        }
+        cell->seq.store(pos + 1, std::memory_order_release);
+        wake(not_empty_);
+        return QueueStatus::Ok;
+    }
+
+    // Ok or Closed. Each retry is a try_push, so 'v' is consumed once, by
+    // the attempt that claims a slot.
+    template <class U>
+    QueueStatus push(U&& v) {
+        return block(not_full_, QueueStatus::Full, nullptr,
+                     [&] { return try_push(std::forward<U>(v)); });
+    }
+
+    // Ok, Timeout or Closed.
+    template <class U, class Rep, class Period>
+    QueueStatus push_wait_for(U&& v, std::chrono::duration<Rep, Period> timeout) {
+        auto deadline = deadline_after(timeout);
+        return block(not_full_, QueueStatus::Full, &deadline,
+                     [&] { return try_push(std::forward<U>(v)); });
+    }
+
+    // Ok, Empty, or Closed once the queue is closed and drained.
+    QueueStatus try_pop(T& out) {
+        uint64_t pos = head_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            uint64_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (dif == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    if (!cell->hole) break;
+                    // A push that threw: release the slot and go on.
+                    cell->hole = false;
+                    cell->seq.store(pos + mask_ + 1, std::memory_order_release);
+                    wake(not_full_);
+                    pos = head_.load(std::memory_order_relaxed);
+                }
+            } else if (dif < 0) {
+                uint64_t tail = tail_.load(std::memory_order_acquire);
+                return (tail & kClosed) && (tail & ~kClosed) <= pos ? QueueStatus::Closed
+                                                                     : QueueStatus::Empty;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        T* v = cell->value();
+        out = std::move(*v);
+        v->~T();
+        cell->seq.store(pos + mask_ + 1, std::memory_order_release);
+        wake(not_full_);
+        return QueueStatus::Ok;
+    }
+
+    // Ok or Closed.
+    QueueStatus pop(T& out) {
+        return block(not_empty_, QueueStatus::Empty, nullptr, [&] { return try_pop(out); });
+    }
+
+    // Ok, Timeout or Closed.
+    template <class Rep, class Period>
+    QueueStatus pop_wait_for(T& out, std::chrono::duration<Rep, Period> timeout) {
+        auto deadline = deadline_after(timeout);
+        return block(not_empty_, QueueStatus::Empty, &deadline, [&] { return try_pop(out); });
+    }
+
+    // Idempotent; wakes every parked producer and consumer.
+    void close() noexcept {
+        tail_.fetch_or(kClosed, std::memory_order_acq_rel);
+        for (Gate* g : {&not_empty_, &not_full_}) {
+            g->epoch.fetch_add(1, std::memory_order_release);
+            futex_wake(g->epoch, INT_MAX);
+        }
+    }
+
+    bool closed() const noexcept { return tail_.load(std::memory_order_acquire) & kClosed; }
+    size_t capacity() const noexcept { return capacity_; }
+
+    size_t size_approx() const noexcept {
+        uint64_t h = head_.load(std::memory_order_relaxed);
+        uint64_t t = tail_.load(std::memory_order_relaxed) & ~kClosed;
+        return t > h ? static_cast<size_t>(t - h) : 0;
+    }
+
+    // Times a caller went to sleep on the futex (full or empty queue).
+    uint64_t parks() const noexcept { return parks_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr uint64_t kClosed = uint64_t(1) << 63;
+
+    struct Cell {
+        std::atomic<uint64_t> seq;
+        bool hole = false;   // the push constructing here threw
+        alignas(T) unsigned char storage[sizeof(T)];
+        T* value() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    // One side's sleepers: parked callers wait for 'epoch' to move.
+    struct alignas(ULLTP_CACHELINE) Gate {
+        std::atomic<uint32_t> epoch{0};
+        std::atomic<uint32_t> waiters{0};
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    template <class Rep, class Period>
+    static Clock::time_point deadline_after(std::chrono::duration<Rep, Period> timeout) {
+        return Clock::now() + std::chrono::duration_cast<Clock::duration>(timeout);
+    }
+
+    static size_t round_up_pow2(size_t x) {
+        size_t n = 2;
+        while (n < x) n <<= 1;
+        return n;
+    }
+
+    // Pairs with the fence in block(): either we see the waiter or it sees
+    // our push/pop, so a parked caller is never missed.
+    void wake(Gate& g) noexcept {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (g.waiters.load(std::memory_order_relaxed) != 0) {
+            g.epoch.fetch_add(1, std::memory_order_release);
+            futex_wake(g.epoch, 1);
+        }
+    }
+
+    // Retries 'attempt' while it returns 'retry': spin first, then park.
+    template <class Attempt>
+    QueueStatus block(Gate& g, QueueStatus retry, const Clock::time_point* deadline,
+                      Attempt attempt) {
+        QueueStatus st;
+        for (unsigned i = 0; i < spin_loops_; ++i) {
+            if ((st = attempt()) != retry) return st;
+            cpu_relax();
+        }
+        // Drops the waiter count on every exit, including a throwing push.
+        struct Waiting {
+            std::atomic<uint32_t>& n;
+            ~Waiting() { n.fetch_sub(1, std::memory_order_relaxed); }
+        };
+        for (;;) {
+            g.waiters.fetch_add(1, std::memory_order_relaxed);
+            Waiting waiting{g.waiters};
+            uint32_t epoch = g.epoch.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            st = attempt();
+            if (st == retry) {
+                if (!deadline) {
+                    futex_wait(g.epoch, epoch);
+                } else {
+                    auto left = *deadline - Clock::now();
+                    if (left <= Clock::duration::zero()) st = QueueStatus::Timeout;
+                    else futex_wait(g.epoch, epoch, left);
+                }
+                parks_.fetch_add(st == retry, std::memory_order_relaxed);
+            }
+            if (st != retry) return st;
+        }
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    const unsigned spin_loops_;
+    Cell* const cells_;
+    alignas(ULLTP_CACHELINE) std::atomic<uint64_t> head_{0};
+    alignas(ULLTP_CACHELINE) std::atomic<uint64_t> tail_{0};   // | kClosed
+    Gate not_empty_;   // consumers park here
+    Gate not_full_;    // producers park here
+    alignas(ULLTP_CACHELINE) std::atomic<uint64_t> parks_{0};
+};
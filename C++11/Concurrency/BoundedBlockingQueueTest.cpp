@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BoundedBlockingQueue.hpp"
+
+namespace {
+
+// Moved into a Payload by a constructor that may throw.
+struct Source {
+    std::vector<int> data;
+    bool fail = false;
+};
+
+struct Payload {
+    std::vector<int> data;
+
+    Payload() = default;
+    Payload(Payload&&) noexcept = default;
+    Payload& operator=(Payload&&) noexcept = default;
+    Payload(Source&& s) : data(std::move(s.data)) {
+        if (s.fail) throw std::runtime_error("conversion failed");
+    }
+};
+
+Source source(int first) { return Source{{first, first + 1, first + 2}, false}; }
+
+void fill(BoundedBlockingQueue<Payload>& q) {
+    for (int i = 0; q.try_push(source(i * 10)) == QueueStatus::Ok; ++i) {
+    }
+}
+
+} // namespace
+
+TEST(BoundedBlockingQueueTest, PushPopClose) {
+    BoundedBlockingQueue<std::string> q(4);
+    EXPECT_EQ(q.push(std::string("a")), QueueStatus::Ok);
+    EXPECT_EQ(q.try_push("b"), QueueStatus::Ok);
+    q.close();
+    EXPECT_EQ(q.try_push("c"), QueueStatus::Closed);
+
+    std::string out;
+    EXPECT_EQ(q.pop(out), QueueStatus::Ok);
+    EXPECT_EQ(out, "a");
+    EXPECT_EQ(q.pop(out), QueueStatus::Ok);
+    EXPECT_EQ(out, "b");
+    EXPECT_EQ(q.pop(out), QueueStatus::Closed);
+}
+
+// A push that finds the queue full or closed leaves its argument alone,
+// even when building the element from it may throw
+TEST(BoundedBlockingQueueTest, FailedPushKeepsThrowingMoveValue) {
+    BoundedBlockingQueue<Payload> q(2);
+    fill(q);
+
+    Source s = source(100);
+    EXPECT_EQ(q.try_push(std::move(s)), QueueStatus::Full);
+    EXPECT_EQ(s.data, (std::vector<int>{100, 101, 102}));
+    EXPECT_EQ(q.push_wait_for(std::move(s), std::chrono::milliseconds(1)), QueueStatus::Timeout);
+    EXPECT_EQ(s.data, (std::vector<int>{100, 101, 102}));
+
+    q.close();
+    EXPECT_EQ(q.push(std::move(s)), QueueStatus::Closed);
+    EXPECT_EQ(s.data, (std::vector<int>{100, 101, 102}));
+}
+
+// A blocked push retries with the caller's value and delivers it intact
+TEST(BoundedBlockingQueueTest, BlockedPushDeliversValue) {
+    BoundedBlockingQueue<Payload> q(2, 4);
+    fill(q);
+
+    std::thread consumer([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        Payload p;
+        q.pop(p);
+    });
+    Source s = source(100);
+    EXPECT_EQ(q.push(std::move(s)), QueueStatus::Ok);
+    consumer.join();
+
+    Payload p;
+    std::vector<int> last;
+    while (q.try_pop(p) == QueueStatus::Ok) last = p.data;
+    EXPECT_EQ(last, (std::vector<int>{100, 101, 102}));
+}
+
+// A construction that throws leaves a hole the consumers skip
+TEST(BoundedBlockingQueueTest, ThrowingPushLeavesHole) {
+    BoundedBlockingQueue<Payload> q(4);
+    Source bad = source(0);
+    bad.fail = true;
+    EXPECT_EQ(q.try_push(source(10)), QueueStatus::Ok);
+    EXPECT_THROW(q.try_push(std::move(bad)), std::runtime_error);
+    EXPECT_EQ(q.try_push(source(20)), QueueStatus::Ok);
+
+    Payload p;
+    ASSERT_EQ(q.try_pop(p), QueueStatus::Ok);
+    EXPECT_EQ(p.data.front(), 10);
+    ASSERT_EQ(q.try_pop(p), QueueStatus::Ok);
+    EXPECT_EQ(p.data.front(), 20);
+    EXPECT_EQ(q.try_pop(p), QueueStatus::Empty);
+
+    // The hole's slot is reusable
+    for (int i = 0; i < 4; ++i) EXPECT_EQ(q.try_push(source(i)), QueueStatus::Ok);
+    EXPECT_EQ(q.try_push(source(9)), QueueStatus::Full);
+}
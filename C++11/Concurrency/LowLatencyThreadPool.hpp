@@ -0,0 +1,1070 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <future>
+#include <type_traits>
+#include <new>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <system_error>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
+
+#include "PoolTrace.hpp"
+#include "SpinWait.hpp"
+#include "../../LowLatencyDataStruct/MPMCBoundedQueue.hpp"
+
+// Per-worker metrics (jobs, queue-wait/exec histograms, idle spins/yields/
+// parks). Off by default; with 0 the counters, timestamps and the extra Job
+// field are not compiled at all and snapshot() reports enabled = false.
+#ifndef ULLTP_ENABLE_METRICS
+#define ULLTP_ENABLE_METRICS 0
+#endif
+
+// --------------------------- Job --------------------------------
+struct Job {
+    using Fn = void(*)(void*);
+    Fn fn{nullptr};
+    void* data{nullptr};
+    void (*deleter)(void*){nullptr}; // optional (for submit path)
+#if ULLTP_ENABLE_METRICS
+    uint64_t enq_ns{0};              // stamped by the pool on enqueue
+#endif
+    bool droppable{false};           // DropOldest may discard it (set by enqueue()/submit())
+
+    void operator()() noexcept {
+        Fn f = fn;
+        void* d = data;
+        if (f) f(d);
+        if (deleter) deleter(d);
+    }
+};
+
+// ----------------- Bounded MPMC queue (Vyukov) -------------------
+// Cell layout of the lane queues: PaddedCells (one job per cache line),
+// DenseCells or SplitCells; see MPMCBoundedQueue.hpp.
+#ifndef ULLTP_QUEUE_LAYOUT
+#define ULLTP_QUEUE_LAYOUT PaddedCells
+#endif
+
+using JobQueue = MPMCBoundedQueue<Job, ULLTP_QUEUE_LAYOUT>;
+
+// ------------------------ Pool options ---------------------------
+// What an idle worker does once its spin_loops budget is used up.
+//   BusySpin  - keep spinning with cpu_relax(); lowest latency, 100% cpu.
+//   SpinYield - std::this_thread::yield() forever (the historical default).
+//   SpinPark  - yield yield_loops times, then sleep on a futex until a
+//               submitter wakes it; ~0% cpu when idle, wake costs a syscall.
+//   Sleep     - sleep_for(sleep_interval) and poll again; latency bounded
+//               by the interval, no wake-up work on the submit path.
+enum class WaitStrategy { BusySpin, SpinYield, SpinPark, Sleep };
+
+inline const char* to_string(WaitStrategy w) noexcept {
+    switch (w) {
+    case WaitStrategy::BusySpin:  return "busy-spin";
+    case WaitStrategy::SpinYield: return "spin-yield";
+    case WaitStrategy::SpinPark:  return "spin-park";
+    case WaitStrategy::Sleep:     return "sleep";
+    }
+    return "?";
+}
+
+// What enqueue()/submit() do when the target lane is full.
+//   Reject     - fail at once (SubmitStatus::Rejected / std::system_error).
+//   CallerRuns - run the job inline on the submitting thread.
+//   Block      - spin spin_loops, then yield until there is room or
+//                block_timeout expires (0 = wait forever; the historical
+//                submit() behaviour).
+//   DropOldest - discard the oldest droppable job of the lane (its deleter
+//                runs, its function doesn't) to make room. Only jobs that
+//                came through enqueue() with a deleter, or submit(), are
+//                droppable; enqueue_raw() jobs (strand drains, graph nodes,
+//                coroutine resumes, timers) are put back at the tail, or run
+//                inline if that slot is taken meanwhile. A lane holding no
+//                droppable job falls back to Block.
+//   Spill      - append to an unbounded per-lane overflow list that workers
+//                drain after the ring. While it is non-empty every push to
+//                the lane goes there too, so the lane stays FIFO.
+enum class OverflowPolicy { Reject, CallerRuns, Block, DropOldest, Spill };
+
+inline const char* to_string(OverflowPolicy p) noexcept {
+    switch (p) {
+    case OverflowPolicy::Reject:     return "reject";
+    case OverflowPolicy::CallerRuns: return "caller-runs";
+    case OverflowPolicy::Block:      return "block";
+    case OverflowPolicy::DropOldest: return "drop-oldest";
+    case OverflowPolicy::Spill:      return "spill";
+    }
+    return "?";
+}
+
+enum class SubmitStatus { Queued, Spilled, RanInline, Rejected, TimedOut };
+
+inline const char* to_string(SubmitStatus s) noexcept {
+    switch (s) {
+    case SubmitStatus::Queued:    return "queued";
+    case SubmitStatus::Spilled:   return "spilled";
+    case SubmitStatus::RanInline: return "ran-inline";
+    case SubmitStatus::Rejected:  return "rejected";
+    case SubmitStatus::TimedOut:  return "timed-out";
+    }
+    return "?";
+}
+
+// The job was (or will be) run; otherwise the caller still owns its data.
+inline bool accepted(SubmitStatus s) noexcept {
+    return s == SubmitStatus::Queued || s == SubmitStatus::Spilled || s == SubmitStatus::RanInline;
+}
+
+// Automatic resizing, evaluated every 'interval' by a controller thread.
+//   grow:   total queued jobs >= grow_depth * active workers on two
+//           consecutive checks -> start one worker (up to max_threads).
+//   retire: some worker has been idle (spin budget used up, or parked) with
+//           no job in between for idle_retire, and the lanes are empty ->
+//           retire the highest-numbered worker (down to min_threads).
+// At most one event per check, and each event restarts the idle clocks.
+struct AutoScale {
+    bool enabled = false;
+    unsigned min_threads = 1;
+    unsigned max_threads = 0;                     // 0 = pool capacity
+    size_t grow_depth = 64;
+    std::chrono::milliseconds idle_retire{1000};
+    std::chrono::milliseconds interval{10};
+};
+
+// Construction-time placement of the workers. Worker i is pinned to
+// cpus[i % cpus.size()]; an empty list leaves the OS scheduler in charge.
+// rt_priority > 0 requests SCHED_FIFO at that priority (needs CAP_SYS_NICE
+// or a suitable RLIMIT_RTPRIO); when refused the worker stays SCHED_OTHER.
+struct PoolOptions {
+    size_t queue_capacity_pow2 = 1024;
+    unsigned spin_loops = 256;
+    std::vector<int> cpus;                  // e.g. the isolcpus= list
+    std::string name_prefix = "ulltp";      // thread name "<prefix>-<i>"
+    int rt_priority = 0;                    // 0 = keep SCHED_OTHER
+
+    WaitStrategy wait = WaitStrategy::SpinYield;
+    unsigned yield_loops = 64;              // SpinPark: yields before parking
+    std::chrono::microseconds sleep_interval{50}; // Sleep: poll period
+
+    // Priority lanes, 0 = highest. Workers always drain lower-numbered lanes
+    // first; with aging_interval = N every Nth job is taken lowest-lane-first
+    // so housekeeping can't starve forever (0 = strict priority).
+    unsigned lanes = 1;                     // 1..kMaxLanes
+    std::vector<size_t> lane_capacity;      // per lane, missing = queue_capacity_pow2
+    unsigned aging_interval = 0;
+
+    OverflowPolicy overflow = OverflowPolicy::Block;
+    std::chrono::nanoseconds block_timeout{0};  // Block: 0 = no limit
+
+    // Worker slots reserved for resize(); 0 = max(threads, hardware
+    // concurrency). Worker i always gets cpus[i % cpus.size()].
+    unsigned max_threads = 0;
+    AutoScale autoscale;
+};
+
+struct ScaleStats {
+    unsigned active = 0;
+    unsigned capacity = 0;
+    uint64_t started = 0;      // workers added after construction
+    uint64_t retired = 0;
+};
+
+// Per-lane counters; enqueued/dequeued come from the queue cursors so the
+// hot path pays nothing for them.
+struct LaneStats {
+    size_t capacity = 0;
+    size_t depth = 0;
+    uint64_t enqueued = 0;
+    uint64_t dequeued = 0;
+    uint64_t full = 0;         // enqueue attempts that found the lane full
+    // How the overflow policy resolved them:
+    uint64_t rejected = 0;
+    uint64_t ran_inline = 0;   // CallerRuns, a control job DropOldest couldn't requeue,
+                               // or a schedule() that found the lane full
+    uint64_t timed_out = 0;
+    uint64_t dropped = 0;      // queued jobs discarded by DropOldest
+    uint64_t spilled = 0;      // jobs that went to the overflow list
+    size_t spill_depth = 0;    // currently in the overflow list
+};
+
+// Log2 latency histogram: bucket b counts samples in [2^(b-1), 2^b) ns.
+struct LatencyHistogram {
+    static constexpr unsigned kBuckets = 40;
+    uint64_t bucket[kBuckets] = {};
+
+    static unsigned bucket_of(uint64_t ns) noexcept {
+        unsigned b = ns ? 64 - __builtin_clzll(ns) : 0;
+        return b < kBuckets ? b : kBuckets - 1;
+    }
+    uint64_t count() const noexcept {
+        uint64_t c = 0;
+        for (uint64_t b : bucket) c += b;
+        return c;
+    }
+    // Upper bound of the bucket holding the q-quantile (0 if empty).
+    uint64_t percentile_ns(double q) const noexcept {
+        uint64_t total = count(), seen = 0;
+        if (!total) return 0;
+        uint64_t rank = static_cast<uint64_t>(q * (total - 1));
+        for (unsigned b = 0; b < kBuckets; ++b) {
+            seen += bucket[b];
+            if (seen > rank) return uint64_t(1) << b;
+        }
+        return uint64_t(1) << (kBuckets - 1);
+    }
+    void merge(const LatencyHistogram& o) noexcept {
+        for (unsigned b = 0; b < kBuckets; ++b) bucket[b] += o.bucket[b];
+    }
+};
+
+struct WorkerStats {
+    uint64_t jobs = 0;
+    uint64_t spins = 0;        // cpu_relax() iterations while idle
+    uint64_t yields = 0;
+    uint64_t parks = 0;        // futex sleeps (SpinPark)
+    LatencyHistogram queue_wait;
+    LatencyHistogram exec;
+
+    void merge(const WorkerStats& o) noexcept {
+        jobs += o.jobs;
+        spins += o.spins;
+        yields += o.yields;
+        parks += o.parks;
+        queue_wait.merge(o.queue_wait);
+        exec.merge(o.exec);
+    }
+};
+
+struct PoolMetrics {
+    bool enabled = false;
+    std::vector<WorkerStats> workers;
+    WorkerStats total;
+    uint64_t full_enqueues = 0;   // summed over lanes
+};
+
+// What was actually applied to a worker; errors hold the errno value
+// (0 = success) so callers can tell "not requested" from "refused".
+struct WorkerPlacement {
+    int cpu = -1;              // pinned cpu, -1 = unpinned
+    int affinity_error = 0;
+    bool realtime = false;     // running SCHED_FIFO
+    int priority = 0;
+    int sched_error = 0;
+    std::string name;
+};
+
+inline const char* placement_error_string(int err) noexcept {
+    return err ? std::strerror(err) : "ok";
+}
+
+// ------------------------ Thread Pool ----------------------------
+class LowLatencyThreadPool {
+public:
+    static constexpr unsigned kMaxLanes = 4;
+
+    LowLatencyThreadPool(unsigned threads, size_t queue_capacity_pow2 = 1024,
+                         unsigned spin_loops = 256)
+    : LowLatencyThreadPool(threads, make_options(queue_capacity_pow2, spin_loops)) {}
+
+    LowLatencyThreadPool(unsigned threads, const PoolOptions& opts)
+    : lane_count_(std::clamp(opts.lanes, 1u, kMaxLanes)), aging_interval_(opts.aging_interval),
+      spin_loops_(opts.spin_loops),
+      wait_(opts.wait), yield_loops_(opts.yield_loops), sleep_interval_(opts.sleep_interval),
+      overflow_(opts.overflow), block_timeout_(opts.block_timeout),
+      opts_(opts), stop_(false)
+    {
+        for (unsigned l = 0; l < lane_count_; ++l) {
+            size_t cap = l < opts.lane_capacity.size() ? opts.lane_capacity[l] : opts.queue_capacity_pow2;
+            lanes_[l].queue = std::make_unique<JobQueue>(cap);
+        }
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        capacity_ = opts.max_threads ? std::max(threads, opts.max_threads)
+                                     : std::max(threads, std::thread::hardware_concurrency());
+        workers_.reset(new Worker[capacity_]);
+#if ULLTP_ENABLE_METRICS
+        counters_.reset(new WorkerCounters[capacity_]);
+#endif
+        placements_.reserve(capacity_);
+        for (unsigned i = 0; i < threads; ++i) start_worker(i);
+        active_.store(threads, std::memory_order_release);
+        if (opts.autoscale.enabled) scaler_ = std::thread([this] { scale_loop(); });
+    }
+
+    ~LowLatencyThreadPool() {
+        shutdown();
+    }
+
+    // --- Ultra-low-latency: zero-allocation enqueue ---
+    // You own 'data' lifetime; optionally supply 'deleter' to clean after run.
+    // 'lane' selects the priority lane (0 = highest, clamped to lanes()-1).
+    // Never waits: returns false when the lane is full, whatever the
+    // overflow policy (a Spill pool still spills while the lane is spilling).
+    bool enqueue_raw(Job::Fn fn, void* data, void(*deleter)(void*) = nullptr,
+                     unsigned lane = 0) noexcept {
+        lane = clamp_lane(lane);
+        if (push(Job{fn, data, deleter}, lane)) return true;
+        lanes_[lane].full.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // enqueue_raw() that applies the pool's overflow policy when the lane is
+    // full. Unless accepted(status), nothing ran and 'data' is still yours.
+    // With a deleter the job may later be discarded by DropOldest.
+    SubmitStatus enqueue(Job::Fn fn, void* data, void(*deleter)(void*) = nullptr,
+                         unsigned lane = 0) noexcept {
+        lane = clamp_lane(lane);
+        Job j{fn, data, deleter};
+        j.droppable = deleter != nullptr;
+        if (push(j, lane)) return spilling(lane) ? SubmitStatus::Spilled : SubmitStatus::Queued;
+        return overflow(j, lane);
+    }
+
+    // Convenience submit with future (may allocate). Prefer enqueue_raw for HFT path.
+    template <class F, class... Args>
+    auto submit(F&& f, Args&&... args)
+        -> std::future<std::invoke_result_t<F, Args...>>
+    {
+        return submit_at(0, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    // submit() into a given priority lane.
+    template <class F, class... Args>
+    auto submit_at(unsigned lane, F&& f, Args&&... args)
+        -> std::future<std::invoke_result_t<F, Args...>>
+    {
+        using R = std::invoke_result_t<F, Args...>;
+        using Packaged = std::packaged_task<R()>;
+
+        // Create heap package; pool will delete via deleter.
+        auto bound = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
+        auto* pkg = new Packaged(std::move(bound));
+        std::future<R> fut = pkg->get_future();
+
+        auto run_pkg = [](void* p) noexcept {
+            auto* pk = static_cast<Packaged*>(p);
+            (*pk)();
+        };
+        auto del_pkg = [](void* p) noexcept {
+            delete static_cast<Packaged*>(p);
+        };
+
+        // A full lane is resolved by the overflow policy; Reject and an
+        // expired Block throw, leaving nothing queued.
+        lane = clamp_lane(lane);
+        Job j{run_pkg, pkg, del_pkg};
+        j.droppable = true;
+        if (push(j, lane)) return fut;
+        SubmitStatus st = overflow(j, lane);
+        if (!accepted(st)) {
+            delete pkg;
+            throw std::system_error(std::make_error_code(st == SubmitStatus::TimedOut
+                                                             ? std::errc::timed_out
+                                                             : std::errc::resource_unavailable_try_again),
+                                    "LowLatencyThreadPool: lane full");
+        }
+        return fut;
+    }
+
+#if defined(__cpp_impl_coroutine)
+    // co_await pool.schedule(): resume the awaiting coroutine on a worker.
+    // If the lane is full the coroutine carries on inline (waiting for room
+    // could deadlock a worker); the co_await then yields false and the
+    // lane's ran_inline counter goes up.
+    struct ScheduleAwaiter {
+        LowLatencyThreadPool* pool;
+        unsigned lane;
+        bool queued = true;
+
+        bool await_ready() const noexcept { return false; }
+        // Once the job is queued a worker may already be running the
+        // coroutine, so only the failure path touches the awaiter again.
+        bool await_suspend(std::coroutine_handle<> h) noexcept {
+            if (pool->enqueue_raw([](void* p) noexcept {
+                    std::coroutine_handle<>::from_address(p).resume();
+                }, h.address(), nullptr, lane))
+                return true;
+            pool->lanes_[pool->clamp_lane(lane)].ran_inline.fetch_add(1, std::memory_order_relaxed);
+            queued = false;
+            return false;
+        }
+        bool await_resume() const noexcept { return queued; }
+    };
+
+    ScheduleAwaiter schedule(unsigned lane = 0) noexcept { return ScheduleAwaiter{this, lane}; }
+#endif
+
+    // --- Help-while-waiting ---
+    // Run one queued job on the calling thread; false if all lanes were empty.
+    bool run_one() noexcept {
+        Job j;
+        unsigned taken = 0;
+        if (!next_job(j, taken)) return false;
+        ULLTP_TRACE(Start, j.fn);
+        j(); // not counted in the per-worker metrics
+        ULLTP_TRACE(End, j.fn);
+        return true;
+    }
+
+    // Run queued jobs on the calling thread until ready() holds. A worker
+    // waiting on its own sub-tasks this way keeps the pool making progress
+    // instead of blocking a thread (or deadlocking a full pool).
+    template <class Pred>
+    void help_until(Pred&& ready) {
+        for (unsigned idle = 0; !ready();) {
+            if (run_one()) {
+                idle = 0;
+            } else if (++idle < spin_loops_.load(std::memory_order_relaxed)) {
+                cpu_relax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // future.get() that helps while the result is pending.
+    template <class T>
+    T wait(std::future<T>& f) {
+        help_until([&] { return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+        return f.get();
+    }
+
+    // Drains and joins. Safe to call multiple times.
+    void shutdown() noexcept {
+        bool expected = false;
+        if (!stop_.compare_exchange_strong(expected, true, std::memory_order_relaxed))
+            return;
+        // Running workers see stop_ on their next idle pass (Sleep within one
+        // interval); no wake-up jobs are queued, so a full lane can't lose
+        // them. Parked workers don't poll stop_; bump the epoch and wake them.
+        wake_epoch_.fetch_add(1, std::memory_order_release);
+        futex_wake(wake_epoch_, INT32_MAX);
+        {
+            std::lock_guard<std::mutex> g(scale_mutex_);
+            scale_cv_.notify_all();
+        }
+        if (scaler_.joinable()) scaler_.join();
+        // Join outside the lock: a job still draining may call resize(),
+        // which takes it (and, seeing stop_, does nothing).
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> g(scale_mutex_);
+            for (unsigned i = 0; i < capacity_; ++i)
+                if (workers_[i].thread.joinable()) threads.push_back(std::move(workers_[i].thread));
+        }
+        for (std::thread& t : threads) t.join();
+        active_.store(0, std::memory_order_release);
+    }
+
+    // Grow or shrink to n workers (clamped to 1..capacity()). New workers
+    // get the next indices, so cpus/name/priority follow PoolOptions.
+    // Retired workers finish the job in hand, then exit; their queued work
+    // stays for the others. Blocks until they have exited, so don't call it
+    // from a pool worker. Returns the new size.
+    unsigned resize(unsigned n) {
+        std::lock_guard<std::mutex> g(scale_mutex_);
+        if (stop_.load(std::memory_order_relaxed)) return 0;
+        return resize_locked(n);
+    }
+
+    // Optional: set a soft spin loop count for both submit & workers.
+    void set_spin_loops(unsigned loops) noexcept { spin_loops_ = loops; }
+
+    // Called by workers that have used up their spin budget, before they
+    // yield/park/sleep. Return true if the hook produced work (e.g. fired
+    // timers) so the worker spins again. nullptr removes the hook. Parked
+    // workers don't run it, so pair with SpinYield/Sleep/BusySpin.
+    // hook and ctx are published together, so a worker never pairs a new
+    // hook with an old ctx; replaced pairs are kept until the pool dies,
+    // as a worker may still be reading one.
+    using IdleHook = bool (*)(void*) noexcept;
+    void set_idle_hook(IdleHook hook, void* ctx) {
+        const IdleHookSlot* slot = nullptr;
+        std::lock_guard<std::mutex> g(hook_mutex_);
+        if (hook) {
+            idle_hooks_.push_back(std::make_unique<const IdleHookSlot>(IdleHookSlot{hook, ctx}));
+            slot = idle_hooks_.back().get();
+        }
+        idle_hook_.store(slot, std::memory_order_release);
+    }
+
+    size_t queue_capacity() const noexcept { return lanes_[0].queue->capacity(); }
+    unsigned lanes() const noexcept { return lane_count_; }
+    size_t lane_capacity(unsigned lane) const noexcept { return lanes_[clamp_lane(lane)].queue->capacity(); }
+
+    LaneStats lane_stats(unsigned lane) const noexcept {
+        const Lane& l = lanes_[clamp_lane(lane)];
+        LaneStats st;
+        st.capacity = l.queue->capacity();
+        st.dequeued = l.queue->dequeued();
+        st.enqueued = l.queue->enqueued();
+        st.depth = st.enqueued > st.dequeued ? static_cast<size_t>(st.enqueued - st.dequeued) : 0;
+        st.full = l.full.load(std::memory_order_relaxed);
+        st.rejected = l.rejected.load(std::memory_order_relaxed);
+        st.ran_inline = l.ran_inline.load(std::memory_order_relaxed);
+        st.timed_out = l.timed_out.load(std::memory_order_relaxed);
+        st.dropped = l.dropped.load(std::memory_order_relaxed);
+        st.spilled = l.spills.load(std::memory_order_relaxed);
+        st.spill_depth = l.spill_depth.load(std::memory_order_relaxed);
+        return st;
+    }
+    unsigned size() const noexcept { return active_.load(std::memory_order_acquire); }
+    unsigned capacity() const noexcept { return capacity_; }
+
+    ScaleStats scale_stats() const noexcept {
+        ScaleStats st;
+        st.active = size();
+        st.capacity = capacity_;
+        st.started = started_.load(std::memory_order_relaxed);
+        st.retired = retired_.load(std::memory_order_relaxed);
+        return st;
+    }
+
+    // Placement applied to each current worker; changes on resize(), so
+    // don't hold the reference across one.
+    const std::vector<WorkerPlacement>& placements() const noexcept { return placements_; }
+    const WorkerPlacement& placement(unsigned worker) const { return placements_.at(worker); }
+
+    WaitStrategy wait_strategy() const noexcept { return wait_; }
+    OverflowPolicy overflow_policy() const noexcept { return overflow_; }
+
+    static constexpr bool metrics_enabled = ULLTP_ENABLE_METRICS != 0;
+
+    // Aggregate the per-worker counters while workers keep running. Each
+    // counter is read atomically; the set is not one consistent cut.
+    PoolMetrics snapshot() const {
+        PoolMetrics m;
+        for (unsigned l = 0; l < lane_count_; ++l)
+            m.full_enqueues += lanes_[l].full.load(std::memory_order_relaxed);
+#if ULLTP_ENABLE_METRICS
+        m.enabled = true;
+        m.workers.resize(high_water_.load(std::memory_order_acquire)); // retired ones too
+        for (size_t w = 0; w < m.workers.size(); ++w) {
+            const WorkerCounters& c = counters_[w];
+            WorkerStats& st = m.workers[w];
+            st.jobs = c.jobs.load(std::memory_order_relaxed);
+            st.spins = c.spins.load(std::memory_order_relaxed);
+            st.yields = c.yields.load(std::memory_order_relaxed);
+            st.parks = c.parks.load(std::memory_order_relaxed);
+            for (unsigned b = 0; b < LatencyHistogram::kBuckets; ++b) {
+                st.queue_wait.bucket[b] = c.wait[b].load(std::memory_order_relaxed);
+                st.exec.bucket[b] = c.exec[b].load(std::memory_order_relaxed);
+            }
+            m.total.merge(st);
+        }
+#endif
+        return m;
+    }
+    // Workers currently asleep on the futex (SpinPark only).
+    unsigned parked() const noexcept { return sleepers_.load(std::memory_order_relaxed); }
+
+private:
+    struct alignas(ULLTP_CACHELINE) Lane {
+        std::unique_ptr<JobQueue> queue;
+        std::atomic<size_t> spill_depth{0};
+        std::atomic<uint64_t> full{0};
+        std::atomic<uint64_t> rejected{0}, ran_inline{0}, timed_out{0}, dropped{0}, spills{0};
+        SpinLock spill_lock;
+        std::deque<Job> spill;       // Spill policy overflow list
+    };
+
+    static PoolOptions make_options(size_t queue_capacity_pow2, unsigned spin_loops) {
+        PoolOptions o;
+        o.queue_capacity_pow2 = queue_capacity_pow2;
+        o.spin_loops = spin_loops;
+        return o;
+    }
+
+    // Pin/name/prioritise through the native handle so the result is known
+    // before the constructor returns. Failures are recorded, never thrown:
+    // a pool without placement is slower, not broken.
+    static WorkerPlacement apply_placement(std::thread& t, unsigned idx, const PoolOptions& opts) {
+        WorkerPlacement wp;
+        wp.name = (opts.name_prefix + "-" + std::to_string(idx)).substr(0, 15);
+#if defined(__linux__)
+        pthread_t h = t.native_handle();
+        pthread_setname_np(h, wp.name.c_str());
+
+        if (!opts.cpus.empty()) {
+            int cpu = opts.cpus[idx % opts.cpus.size()];
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            wp.affinity_error = pthread_setaffinity_np(h, sizeof(set), &set);
+            if (wp.affinity_error == 0) wp.cpu = cpu;
+        }
+
+        if (opts.rt_priority > 0) {
+            sched_param sp{};
+            sp.sched_priority = std::clamp(opts.rt_priority,
+                                           sched_get_priority_min(SCHED_FIFO),
+                                           sched_get_priority_max(SCHED_FIFO));
+            wp.sched_error = pthread_setschedparam(h, SCHED_FIFO, &sp);
+            if (wp.sched_error == 0) {
+                wp.realtime = true;
+                wp.priority = sp.sched_priority;
+            }
+        }
+#else
+        (void)t;
+        if (!opts.cpus.empty()) wp.affinity_error = ENOTSUP;
+        if (opts.rt_priority > 0) wp.sched_error = ENOTSUP;
+#endif
+        return wp;
+    }
+
+    // Enqueue and, for SpinPark, wake a sleeper. The fence pairs with the
+    // one in park(): either we see the sleeper count or it sees our job, so
+    // busy pools never pay for the syscall.
+    bool push(const Job& j, unsigned lane) noexcept {
+#if ULLTP_ENABLE_METRICS
+        Job stamped = j;
+        stamped.enq_ns = metrics_now();
+#else
+        const Job& stamped = j;
+#endif
+        if (spilling(lane)) {
+            spill(stamped, lane);
+            return true;
+        }
+        if (!lanes_[lane].queue->enqueue(stamped)) return false;
+        ULLTP_TRACE(Enqueue, j.fn);
+        notify();
+        return true;
+    }
+
+    void notify() noexcept {
+        if (wait_ == WaitStrategy::SpinPark) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (sleepers_.load(std::memory_order_relaxed) != 0) {
+                wake_epoch_.fetch_add(1, std::memory_order_release);
+                futex_wake(wake_epoch_, 1);
+            }
+        }
+    }
+
+    bool spilling(unsigned lane) const noexcept {
+        return overflow_ == OverflowPolicy::Spill &&
+               lanes_[lane].spill_depth.load(std::memory_order_acquire) != 0;
+    }
+
+    void spill(const Job& j, unsigned lane) noexcept {
+        Lane& l = lanes_[lane];
+        {
+            std::lock_guard<SpinLock> g(l.spill_lock);
+            l.spill.push_back(j);
+            l.spill_depth.fetch_add(1, std::memory_order_release);
+        }
+        ULLTP_TRACE(Enqueue, j.fn);
+        l.spills.fetch_add(1, std::memory_order_relaxed);
+        notify();
+    }
+
+    bool take_spilled(Lane& l, Job& j) noexcept {
+        if (l.spill_depth.load(std::memory_order_acquire) == 0) return false;
+        std::lock_guard<SpinLock> g(l.spill_lock);
+        if (l.spill.empty()) return false;
+        j = l.spill.front();
+        l.spill.pop_front();
+        l.spill_depth.fetch_sub(1, std::memory_order_release);
+        return true;
+    }
+
+    // Slow path once push() found the lane full.
+    SubmitStatus overflow(Job& j, unsigned lane) noexcept {
+        Lane& l = lanes_[lane];
+        l.full.fetch_add(1, std::memory_order_relaxed);
+        switch (overflow_) {
+        case OverflowPolicy::Reject:
+            l.rejected.fetch_add(1, std::memory_order_relaxed);
+            return SubmitStatus::Rejected;
+        case OverflowPolicy::CallerRuns:
+            l.ran_inline.fetch_add(1, std::memory_order_relaxed);
+            ULLTP_TRACE(Start, j.fn);
+            j();
+            ULLTP_TRACE(End, j.fn);
+            return SubmitStatus::RanInline;
+        case OverflowPolicy::DropOldest:
+            if (drop_oldest(j, lane)) return SubmitStatus::Queued;
+            break;
+        case OverflowPolicy::Spill:
+            spill(j, lane);
+            return SubmitStatus::Spilled;
+        case OverflowPolicy::Block:
+            break;
+        }
+        // Busy-wait a little to preserve latency, then yield until the deadline.
+        const auto deadline = std::chrono::steady_clock::now() + block_timeout_;
+        for (unsigned i = 0;; ++i) {
+            if (push(j, lane)) return SubmitStatus::Queued;
+            if (i < spin_loops_.load(std::memory_order_relaxed)) {
+                cpu_relax();
+                continue;
+            }
+            if (block_timeout_.count() && std::chrono::steady_clock::now() >= deadline) {
+                l.timed_out.fetch_add(1, std::memory_order_relaxed);
+                return SubmitStatus::TimedOut;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // DropOldest: make room by discarding the oldest droppable job. Control
+    // jobs met on the way go back to the tail; if a racing producer took
+    // that slot they run here rather than get lost. Gives up after one lap
+    // of the ring, i.e. when nothing queued is droppable.
+    bool drop_oldest(Job& j, unsigned lane) noexcept {
+        Lane& l = lanes_[lane];
+        const size_t lap = l.queue->capacity();
+        for (size_t seen = 0; seen < lap;) {
+            if (push(j, lane)) return true;
+            Job old;
+            if (!l.queue->dequeue(old)) continue;
+            ++seen;
+            if (old.droppable) {
+                l.dropped.fetch_add(1, std::memory_order_relaxed);
+                if (old.deleter) old.deleter(old.data);
+            } else if (!push(old, lane)) {
+                l.ran_inline.fetch_add(1, std::memory_order_relaxed);
+                ULLTP_TRACE(Start, old.fn);
+                old();
+                ULLTP_TRACE(End, old.fn);
+            }
+        }
+        return false;
+    }
+
+    // Announce ourselves as a sleeper, re-check the queue, then sleep until
+    // the epoch moves. Returns true if the re-check found a job.
+    bool park(Job& j, unsigned& taken, unsigned self) noexcept {
+        sleepers_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint32_t epoch = wake_epoch_.load(std::memory_order_acquire);
+        bool got = next_job(j, taken);
+        if (!got && !stop_.load(std::memory_order_relaxed) &&
+            !workers_[self].retire.load(std::memory_order_relaxed)) {
+            count(self, &WorkerCounters::parks);
+            futex_wait(wake_epoch_, epoch);
+        }
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        return got;
+    }
+
+    unsigned clamp_lane(unsigned lane) const noexcept {
+        return lane < lane_count_ ? lane : lane_count_ - 1;
+    }
+
+    // The ring first: while a lane spills, everything in its ring is older.
+    bool take(Lane& l, Job& j) noexcept {
+        if (l.queue->dequeue(j) || (overflow_ == OverflowPolicy::Spill && take_spilled(l, j))) {
+            ULLTP_TRACE(Dequeue, j.fn);
+            return true;
+        }
+        return false;
+    }
+
+    // Highest lane first; every aging_interval_ jobs one pass starts from
+    // the lowest lane instead.
+    bool next_job(Job& j, unsigned& taken) noexcept {
+        if (aging_interval_ && taken >= aging_interval_) {
+            taken = 0;
+            for (unsigned l = lane_count_; l-- > 1; )
+                if (take(lanes_[l], j)) return true;
+        }
+        for (unsigned l = 0; l < lane_count_; ++l) {
+            if (take(lanes_[l], j)) {
+                ++taken;
+                return true;
+            }
+        }
+        return false;
+    }
+
+#if ULLTP_ENABLE_METRICS
+    // Single writer per worker: plain load+store, no locked RMW on the hot path.
+    struct alignas(ULLTP_CACHELINE) WorkerCounters {
+        std::atomic<uint64_t> jobs{0}, spins{0}, yields{0}, parks{0};
+        std::atomic<uint64_t> wait[LatencyHistogram::kBuckets] = {};
+        std::atomic<uint64_t> exec[LatencyHistogram::kBuckets] = {};
+    };
+
+    static uint64_t metrics_now() noexcept {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    static void bump(std::atomic<uint64_t>& c) noexcept {
+        c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    void count(unsigned self, std::atomic<uint64_t> WorkerCounters::*field) noexcept {
+        bump(counters_[self].*field);
+    }
+#else
+    struct WorkerCounters { int jobs, spins, yields, parks; };
+    void count(unsigned, int WorkerCounters::*) noexcept {}
+#endif
+
+    // Null jobs are wake signals (shutdown) and are not counted.
+    void run_job(Job& j, unsigned self) noexcept {
+        if (!j.fn) return;
+        ULLTP_TRACE(Start, j.fn);
+#if ULLTP_ENABLE_METRICS
+        WorkerCounters& c = counters_[self];
+        uint64_t start = metrics_now();
+        j();
+        uint64_t end = metrics_now();
+        bump(c.jobs);
+        bump(c.wait[LatencyHistogram::bucket_of(start - j.enq_ns)]);
+        bump(c.exec[LatencyHistogram::bucket_of(end - start)]);
+#else
+        (void)self;
+        j();
+#endif
+        ULLTP_TRACE(End, j.fn);
+    }
+
+    void worker_loop(unsigned self) noexcept {
+        Worker& me = workers_[self];
+#if ULLTP_ENABLE_TRACE
+        ULLTP_TRACE_THREAD((opts_.name_prefix + "-" + std::to_string(self)).c_str());
+#endif
+        Job j;
+        unsigned spins = 0;
+        unsigned taken = 0;
+        bool idle = false;
+        // 'retire' is only looked at between jobs.
+        while (!stop_.load(std::memory_order_relaxed) && !me.retire.load(std::memory_order_relaxed)) {
+            if (next_job(j, taken)) {
+                spins = 0;
+                if (idle) {
+                    idle = false;
+                    me.idle.store(false, std::memory_order_relaxed);
+                    me.busy_epoch.store(me.busy_epoch.load(std::memory_order_relaxed) + 1,
+                                        std::memory_order_relaxed);
+                }
+                run_job(j, self);
+                continue;
+            }
+            const unsigned budget = spin_loops_.load(std::memory_order_relaxed);
+            // Spin a bit for ultra-low latency handoff
+            if (spins < budget) {
+                ++spins;
+                count(self, &WorkerCounters::spins);
+                cpu_relax();
+                continue;
+            }
+            if (!idle) {
+                idle = true;
+                me.idle.store(true, std::memory_order_relaxed);
+            }
+            if (const IdleHookSlot* h = idle_hook_.load(std::memory_order_acquire)) {
+                if (h->hook(h->ctx)) {
+                    spins = 0;
+                    continue;
+                }
+            }
+            if (wait_ == WaitStrategy::BusySpin) {
+                count(self, &WorkerCounters::spins);
+                cpu_relax();
+                continue;
+            }
+            // Back off to avoid burning a full core indefinitely
+            switch (wait_) {
+            case WaitStrategy::SpinPark:
+                if (spins - budget < yield_loops_) {
+                    ++spins;
+                    count(self, &WorkerCounters::yields);
+                    std::this_thread::yield();
+                } else {
+                    spins = 0; // woken: spin again before the next park
+                    if (park(j, taken, self)) {
+                        idle = false;
+                        me.idle.store(false, std::memory_order_relaxed);
+                        me.busy_epoch.store(me.busy_epoch.load(std::memory_order_relaxed) + 1,
+                                            std::memory_order_relaxed);
+                        run_job(j, self);
+                    }
+                }
+                break;
+            case WaitStrategy::Sleep:
+                std::this_thread::sleep_for(sleep_interval_);
+                break;
+            default:
+                count(self, &WorkerCounters::yields);
+                std::this_thread::yield();
+                break;
+            }
+        }
+        me.idle.store(true, std::memory_order_relaxed);
+        if (!stop_.load(std::memory_order_relaxed)) return; // retired
+        // Drain remaining work on shutdown
+        while (next_job(j, taken)) {
+            run_job(j, self);
+        }
+    }
+
+    // ------------------------- Elastic sizing -------------------------
+    struct alignas(ULLTP_CACHELINE) Worker {
+        std::thread thread;
+        std::atomic<bool> retire{false};
+        std::atomic<bool> idle{false};          // written by the worker only
+        std::atomic<uint64_t> busy_epoch{0};    // bumped on each idle -> busy
+    };
+
+    struct IdleHookSlot {
+        IdleHook hook;
+        void* ctx;
+    };
+
+    // Caller holds scale_mutex_ (or is the constructor).
+    void start_worker(unsigned i) {
+        Worker& w = workers_[i];
+        if (w.thread.joinable()) w.thread.join(); // retired earlier
+        w.retire.store(false, std::memory_order_relaxed);
+        w.idle.store(false, std::memory_order_relaxed);
+        w.thread = std::thread([this, i] { this->worker_loop(i); });
+        placements_.push_back(apply_placement(w.thread, i, opts_));
+        if (high_water_.load(std::memory_order_relaxed) <= i)
+            high_water_.store(i + 1, std::memory_order_release);
+    }
+
+    unsigned resize_locked(unsigned n) {
+        n = std::clamp(n, 1u, capacity_);
+        unsigned cur = active_.load(std::memory_order_relaxed);
+        if (n > cur) {
+            for (unsigned i = cur; i < n; ++i) start_worker(i);
+            started_.fetch_add(n - cur, std::memory_order_relaxed);
+            active_.store(n, std::memory_order_release);
+        } else if (n < cur) {
+            // Shrink size() first so helpers stop counting on them.
+            active_.store(n, std::memory_order_release);
+            for (unsigned i = n; i < cur; ++i) workers_[i].retire.store(true, std::memory_order_relaxed);
+            wake_epoch_.fetch_add(1, std::memory_order_release); // parked ones re-check
+            futex_wake(wake_epoch_, INT32_MAX);
+            for (unsigned i = n; i < cur; ++i) workers_[i].thread.join();
+            placements_.resize(n);
+            retired_.fetch_add(cur - n, std::memory_order_relaxed);
+        }
+        return n;
+    }
+
+    size_t queued() const noexcept {
+        size_t d = 0;
+        for (unsigned l = 0; l < lane_count_; ++l)
+            d += lanes_[l].queue->size_approx() + lanes_[l].spill_depth.load(std::memory_order_relaxed);
+        return d;
+    }
+
+    void scale_loop() {
+        const AutoScale& as = opts_.autoscale;
+        const unsigned lo = std::clamp(as.min_threads, 1u, capacity_);
+        const unsigned hi = as.max_threads ? std::clamp(as.max_threads, lo, capacity_) : capacity_;
+        using Clock = std::chrono::steady_clock;
+        std::vector<Clock::time_point> idle_since(capacity_);
+        std::vector<uint64_t> seen_epoch(capacity_, ~uint64_t(0));
+        unsigned deep = 0;
+
+        std::unique_lock<std::mutex> lk(scale_mutex_);
+        while (!stop_.load(std::memory_order_relaxed)) {
+            scale_cv_.wait_for(lk, as.interval);
+            if (stop_.load(std::memory_order_relaxed)) break;
+            const auto now = Clock::now();
+            const unsigned cur = active_.load(std::memory_order_relaxed);
+            const size_t depth = queued();
+
+            deep = depth >= as.grow_depth * cur ? deep + 1 : 0;
+            bool idle_long = false;
+            for (unsigned i = 0; i < cur; ++i) {
+                const Worker& w = workers_[i];
+                uint64_t e = w.busy_epoch.load(std::memory_order_relaxed);
+                if (!w.idle.load(std::memory_order_relaxed) || e != seen_epoch[i]) {
+                    seen_epoch[i] = w.idle.load(std::memory_order_relaxed) ? e : ~uint64_t(0);
+                    idle_since[i] = now;
+                } else if (now - idle_since[i] >= as.idle_retire) {
+                    idle_long = true;
+                }
+            }
+
+            unsigned target = cur;
+            if (deep >= 2 && cur < hi) target = cur + 1;
+            else if (idle_long && depth == 0 && cur > lo) target = cur - 1;
+            else if (cur < lo) target = lo;
+            if (target != cur) {
+                resize_locked(target);
+                deep = 0;
+                std::fill(seen_epoch.begin(), seen_epoch.end(), ~uint64_t(0));
+            }
+        }
+    }
+
+    Lane lanes_[kMaxLanes];
+    const unsigned lane_count_;
+    const unsigned aging_interval_;
+    std::unique_ptr<Worker[]> workers_;
+    unsigned capacity_ = 0;
+    std::vector<WorkerPlacement> placements_;
+    std::atomic<unsigned> spin_loops_;
+    const WaitStrategy wait_;
+    const unsigned yield_loops_;
+    const std::chrono::microseconds sleep_interval_;
+    const OverflowPolicy overflow_;
+    const std::chrono::nanoseconds block_timeout_;
+    alignas(ULLTP_CACHELINE) std::atomic<uint32_t> wake_epoch_{0};
+    std::atomic<uint32_t> sleepers_{0};
+    std::atomic<const IdleHookSlot*> idle_hook_{nullptr};
+    std::mutex hook_mutex_;
+    std::vector<std::unique_ptr<const IdleHookSlot>> idle_hooks_; // under hook_mutex_
+    const PoolOptions opts_;                      // placement/autoscale for new workers
+    std::atomic<unsigned> active_{0};
+    std::atomic<unsigned> high_water_{0};
+    std::atomic<uint64_t> started_{0};
+    std::atomic<uint64_t> retired_{0};
+    std::mutex scale_mutex_;                      // resize(), autoscaler, shutdown
+    std::condition_variable scale_cv_;
+    std::thread scaler_;
+    std::atomic<bool> stop_;
+#if ULLTP_ENABLE_METRICS
+    std::unique_ptr<WorkerCounters[]> counters_;
+#endif
+};
+
+// --------------------- Example raw helpers -----------------------
+template <typename F>
+struct RawThunk {
+    F fn;
+    static void run(void* p) noexcept {
+        F* fp = static_cast<F*>(p);
+        (*fp)();
+    }
+    static void del(void* p) noexcept {
+        delete static_cast<F*>(p);
+    }
+};
+
+// Helper to enqueue a callable without future, with heap-owned callable.
+// Prefer this only if you don't want to manage your own void* payload.
+template <class Pool, class F>
+inline bool enqueue_callable(Pool& pool, F&& f) {
+    using Fn = std::decay_t<F>;
+    auto* holder = new Fn(std::forward<F>(f));
+    return pool.enqueue_raw(&RawThunk<Fn>::run, holder, &RawThunk<Fn>::del);
+}
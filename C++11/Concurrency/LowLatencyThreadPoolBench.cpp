@@ -0,0 +1,956 @@
+/**
+ * Micro benchmarks for LowLatencyThreadPool.
+ *
+ *   g++ -std=c++17 -O2 -pthread LowLatencyThreadPoolBench.cpp -o bench.out
+ *   ./bench.out [benchmark] [args...]
+ *
+ * Build with -std=c++20 to include the coroutine benchmark, and with
+ * -DULLTP_ENABLE_METRICS=1 to have 'metrics' print per-worker counters
+ * (likewise -DULLTP_ENABLE_TRACE=1 for 'trace').
+ *
+ * Without arguments every benchmark runs with its defaults. Numbers are only
+ * meaningful on a quiet machine; run pinned benchmarks on isolated cores.
+ */
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <numeric>
+#include <queue>
+#include <time.h>
+
+// std::execution::par needs TBB with libstdc++: build with
+// -DULLTP_BENCH_STD_PAR -ltbb to include it in the 'parallel' benchmark.
+#ifdef ULLTP_BENCH_STD_PAR
+#include <execution>
+#endif
+
+#include "LowLatencyThreadPool.hpp"
+#include "../../LowLatencyDataStruct/EventCount.hpp"
+#include "../../LowLatencyDataStruct/FanInQueue.hpp"
+#include "../../LowLatencyDataStruct/MPSCQueue.hpp"
+#include "../../LowLatencyDataStruct/UnboundedSPSCQueue.hpp"
+#include "NumaThreadPool.hpp"
+#include "ParallelAlgorithms.hpp"
+#include "Strand.hpp"
+#include "TaskGraph.hpp"
+#include "TaskGroup.hpp"
+#include "TimerWheel.hpp"
+#if defined(__cpp_impl_coroutine)
+#include "PoolCoroutines.hpp"
+#endif
+
+using BenchClock = std::chrono::steady_clock;
+
+static inline uint64_t now_ns() noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        BenchClock::now().time_since_epoch()).count();
+}
+
+static void print_percentiles(const char* label, std::vector<uint64_t>& ns) {
+    if (ns.empty()) return;
+    std::sort(ns.begin(), ns.end());
+    auto at = [&](double q) { return ns[std::min(ns.size() - 1, size_t(q * ns.size()))]; };
+    std::cout << label
+              << " p50=" << at(0.50) << "ns"
+              << " p99=" << at(0.99) << "ns"
+              << " p99.9=" << at(0.999) << "ns"
+              << " max=" << ns.back() << "ns"
+              << " (n=" << ns.size() << ")\n";
+}
+
+static std::vector<int> parse_cpus(const char* list) {
+    std::vector<int> cpus;
+    for (const char* p = list; *p; ) {
+        cpus.push_back(std::atoi(p));
+        const char* comma = std::strchr(p, ',');
+        if (!comma) break;
+        p = comma + 1;
+    }
+    return cpus;
+}
+
+// ------------------------- jitter --------------------------------
+// Enqueue-to-start latency of a single spinning worker, unpinned and then
+// pinned to the given cpu. The tail (p99.9/max) is what pinning improves.
+struct JitterProbe {
+    uint64_t sent_ns;
+    std::atomic<uint64_t> seen_ns{0};
+};
+
+static void jitter_sample(LowLatencyThreadPool& pool, size_t samples, std::vector<uint64_t>& out) {
+    JitterProbe probe;
+    out.clear();
+    out.reserve(samples);
+    for (size_t i = 0; i < samples; ++i) {
+        probe.seen_ns.store(0, std::memory_order_relaxed);
+        probe.sent_ns = now_ns();
+        pool.enqueue_raw([](void* p) noexcept {
+            static_cast<JitterProbe*>(p)->seen_ns.store(now_ns(), std::memory_order_release);
+        }, &probe);
+        uint64_t seen;
+        for (unsigned spin = 0; (seen = probe.seen_ns.load(std::memory_order_acquire)) == 0; ++spin) {
+            if (spin < 4096) cpu_relax();
+            else std::this_thread::yield(); // don't starve the worker on a shared core
+        }
+        out.push_back(seen - probe.sent_ns);
+    }
+}
+
+static void bench_jitter(int argc, char** argv) {
+    size_t samples = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 200000;
+    std::vector<int> cpus = argc > 0 ? parse_cpus(argv[0]) : std::vector<int>{1};
+    std::vector<uint64_t> ns;
+
+    {
+        PoolOptions opts;
+        opts.spin_loops = 1u << 20;
+        LowLatencyThreadPool pool(1, opts);
+        jitter_sample(pool, samples, ns);
+        print_percentiles("jitter unpinned     ", ns);
+    }
+    {
+        PoolOptions opts;
+        opts.spin_loops = 1u << 20;
+        opts.cpus = cpus;
+        opts.rt_priority = argc > 1 ? std::atoi(argv[1]) : 0;
+        LowLatencyThreadPool pool(1, opts);
+        const WorkerPlacement& wp = pool.placement(0);
+        if (wp.cpu < 0)
+            std::cout << "jitter: pinning refused: " << placement_error_string(wp.affinity_error) << "\n";
+        if (opts.rt_priority > 0 && !wp.realtime)
+            std::cout << "jitter: SCHED_FIFO refused: " << placement_error_string(wp.sched_error) << "\n";
+        jitter_sample(pool, samples, ns);
+        print_percentiles("jitter pinned       ", ns);
+    }
+}
+
+// -------------------------- wait ---------------------------------
+// Per wait strategy: wake-up latency of jobs arriving every gap_us (long
+// enough for workers to go idle) and the cpu burnt by an idle pool.
+static double process_cpu_seconds() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void bench_wait(int argc, char** argv) {
+    unsigned threads = argc > 0 ? std::atoi(argv[0]) : 2;
+    unsigned gap_us = argc > 1 ? std::atoi(argv[1]) : 500;
+    size_t samples = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000;
+    const WaitStrategy strategies[] = {WaitStrategy::BusySpin, WaitStrategy::SpinYield,
+                                       WaitStrategy::SpinPark, WaitStrategy::Sleep};
+    std::vector<uint64_t> ns;
+    for (WaitStrategy w : strategies) {
+        PoolOptions opts;
+        opts.wait = w;
+        opts.spin_loops = 1024;
+        LowLatencyThreadPool pool(threads, opts);
+
+        JitterProbe probe;
+        ns.clear();
+        for (size_t i = 0; i < samples; ++i) {
+            std::this_thread::sleep_for(std::chrono::microseconds(gap_us));
+            probe.seen_ns.store(0, std::memory_order_relaxed);
+            probe.sent_ns = now_ns();
+            pool.enqueue_raw([](void* p) noexcept {
+                static_cast<JitterProbe*>(p)->seen_ns.store(now_ns(), std::memory_order_release);
+            }, &probe);
+            while (probe.seen_ns.load(std::memory_order_acquire) == 0) std::this_thread::yield();
+            ns.push_back(probe.seen_ns.load(std::memory_order_relaxed) - probe.sent_ns);
+        }
+
+        double cpu0 = process_cpu_seconds();
+        auto t0 = BenchClock::now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        double wall = std::chrono::duration<double>(BenchClock::now() - t0).count();
+        double idle_cpu = (process_cpu_seconds() - cpu0) / wall * 100.0;
+
+        std::string label = std::string("wait ") + to_string(w);
+        label.resize(20, ' ');
+        print_percentiles(label.c_str(), ns);
+        std::cout << "                     idle cpu=" << idle_cpu << "% of one core\n";
+    }
+}
+
+// -------------------------- lanes --------------------------------
+// High-priority probe latency while another thread floods low-priority
+// jobs: once with everything in one lane, once with the flood in lane 1.
+static void spin_for_ns(uint64_t ns) noexcept {
+    uint64_t end = now_ns() + ns;
+    while (now_ns() < end) cpu_relax();
+}
+
+static void bench_lanes(int argc, char** argv) {
+    unsigned threads = argc > 0 ? std::atoi(argv[0]) : 1;
+    size_t probes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    std::vector<uint64_t> ns;
+    for (unsigned lanes : {1u, 2u}) {
+        PoolOptions opts;
+        opts.lanes = lanes;
+        opts.queue_capacity_pow2 = 1 << 16;
+        opts.aging_interval = 64;
+        LowLatencyThreadPool pool(threads, opts);
+
+        std::atomic<bool> flooding{true};
+        std::thread flooder([&] {
+            auto busy = [](void*) noexcept { spin_for_ns(2000); };
+            while (flooding.load(std::memory_order_relaxed)) {
+                if (!pool.enqueue_raw(busy, nullptr, nullptr, 1)) std::this_thread::yield();
+            }
+        });
+
+        JitterProbe probe;
+        ns.clear();
+        for (size_t i = 0; i < probes; ++i) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            probe.seen_ns.store(0, std::memory_order_relaxed);
+            probe.sent_ns = now_ns();
+            while (!pool.enqueue_raw([](void* p) noexcept {
+                static_cast<JitterProbe*>(p)->seen_ns.store(now_ns(), std::memory_order_release);
+            }, &probe, nullptr, 0)) std::this_thread::yield();
+            while (probe.seen_ns.load(std::memory_order_acquire) == 0) std::this_thread::yield();
+            ns.push_back(probe.seen_ns.load(std::memory_order_relaxed) - probe.sent_ns);
+        }
+        flooding.store(false, std::memory_order_relaxed);
+        flooder.join();
+
+        print_percentiles(lanes == 1 ? "lanes shared queue  " : "lanes high lane     ", ns);
+        for (unsigned l = 0; l < pool.lanes(); ++l) {
+            LaneStats st = pool.lane_stats(l);
+            std::cout << "                     lane " << l << " enq=" << st.enqueued
+                      << " deq=" << st.dequeued << " depth=" << st.depth
+                      << " full=" << st.full << "\n";
+        }
+    }
+}
+
+// -------------------------- timers -------------------------------
+// Schedule n one-shot timers spread over window_ms, cancel a third of them
+// (order timeouts that got filled), then report insert/cancel cost and how
+// late the survivors started on a pool worker.
+static void bench_timers(int argc, char** argv) {
+    size_t n = argc > 0 ? std::strtoul(argv[0], nullptr, 10) : 100000;
+    unsigned window_ms = argc > 1 ? std::atoi(argv[1]) : 1000;
+
+    PoolOptions popts;
+    popts.queue_capacity_pow2 = 1 << 16;
+    popts.wait = WaitStrategy::SpinPark;
+    LowLatencyThreadPool pool(argc > 2 ? std::atoi(argv[2]) : 2, popts);
+    TimerWheelOptions topts;
+    topts.capacity = n;
+    TimerWheel wheel(pool, topts);
+
+    struct Probe { TimerWheel::Clock::time_point due; std::atomic<int64_t> late_ns{-1}; };
+    std::vector<Probe> probes(n);
+    std::vector<TimerId> ids(n);
+    uint64_t seed = 88172645463325252ull;
+    auto start = TimerWheel::Clock::now() + std::chrono::milliseconds(20);
+    for (Probe& p : probes) {
+        seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+        p.due = start + std::chrono::microseconds(seed % (uint64_t(window_ms) * 1000));
+    }
+
+    uint64_t t0 = now_ns();
+    for (size_t i = 0; i < n; ++i) {
+        ids[i] = wheel.schedule_raw(probes[i].due, [](void* p) noexcept {
+            auto* pr = static_cast<Probe*>(p);
+            pr->late_ns.store((TimerWheel::Clock::now() - pr->due).count(), std::memory_order_relaxed);
+        }, &probes[i]);
+    }
+    uint64_t t1 = now_ns();
+    size_t cancelled = 0;
+    for (size_t i = 0; i < n; i += 3) cancelled += wheel.cancel(ids[i]);
+    uint64_t t2 = now_ns();
+
+    std::this_thread::sleep_until(start + std::chrono::milliseconds(window_ms + 50));
+    std::vector<uint64_t> late;
+    for (Probe& p : probes) {
+        int64_t l = p.late_ns.load(std::memory_order_relaxed);
+        if (l >= 0) late.push_back(static_cast<uint64_t>(l));
+    }
+    std::cout << "timers schedule=" << (t1 - t0) / std::max<size_t>(1, n) << "ns/op"
+              << " cancel=" << (t2 - t1) / std::max<size_t>(1, (n + 2) / 3) << "ns/op"
+              << " cancelled=" << cancelled << " fired=" << wheel.fired() << "\n";
+    print_percentiles("timers lateness     ", late);
+}
+
+// -------------------------- graph --------------------------------
+// normalize -> (A, B, C) -> aggregate -> risk -> send, node work_ns each:
+// per-tick latency as a TaskGraph vs chained submit() + future.get().
+static void bench_graph(int argc, char** argv) {
+    unsigned threads = argc > 0 ? std::atoi(argv[0]) : 4;
+    size_t ticks = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    uint64_t work_ns = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 500;
+    PoolOptions opts;
+    opts.spin_loops = 4096;
+    LowLatencyThreadPool pool(threads, opts);
+    auto work = [work_ns] { spin_for_ns(work_ns); };
+    std::vector<uint64_t> ns;
+
+    TaskGraph graph(pool);
+    auto normalize = graph.add(work, "normalize");
+    auto aggregate = graph.add(work, "aggregate");
+    for (int i = 0; i < 3; ++i) {
+        auto sig = graph.add(work, "signal");
+        graph.precede(normalize, sig);
+        graph.precede(sig, aggregate);
+    }
+    auto risk = graph.add(work, "risk");
+    auto send = graph.add(work, "send");
+    graph.precede(aggregate, risk);
+    graph.precede(risk, send);
+    graph.seal();
+
+    for (size_t i = 0; i < ticks; ++i) {
+        uint64_t t0 = now_ns();
+        graph.run_and_wait();
+        ns.push_back(now_ns() - t0);
+    }
+    print_percentiles("graph dag           ", ns);
+
+    ns.clear();
+    for (size_t i = 0; i < ticks; ++i) {
+        uint64_t t0 = now_ns();
+        pool.submit(work).get();
+        auto a = pool.submit(work), b = pool.submit(work), c = pool.submit(work);
+        a.get(); b.get(); c.get();
+        pool.submit(work).get();
+        pool.submit(work).get();
+        pool.submit(work).get();
+        ns.push_back(now_ns() - t0);
+    }
+    print_percentiles("graph submit+get    ", ns);
+}
+
+// ------------------------- parallel ------------------------------
+// for / reduce / transform / scan over n doubles: serial, on the pool
+// (caller participates) and, if built in, std::execution::par.
+template <class F>
+static double best_ms(int reps, F&& f) {
+    double best = 1e300;
+    for (int r = 0; r < reps; ++r) {
+        uint64_t t0 = now_ns();
+        f();
+        best = std::min(best, (now_ns() - t0) / 1e6);
+    }
+    return best;
+}
+
+static void bench_parallel(int argc, char** argv) {
+    unsigned threads = argc > 0 ? std::atoi(argv[0]) : std::max(1u, std::thread::hardware_concurrency() - 1);
+    size_t max_n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    ParallelOptions popts;
+    popts.grain = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 16384;
+    LowLatencyThreadPool pool(threads);
+
+    for (size_t n = 1000000; n <= max_n; n *= 10) {
+        std::vector<double> in(n), out(n);
+        std::iota(in.begin(), in.end(), 0.0);
+        auto body = [](double x) { return x * 1.000001 + 0.5; };
+        volatile double sink = 0;
+        const int reps = 5;
+
+        double s_for = best_ms(reps, [&] { for (size_t i = 0; i < n; ++i) out[i] = body(in[i]); });
+        double s_red = best_ms(reps, [&] { sink = std::accumulate(in.begin(), in.end(), 0.0); });
+        double s_scan = best_ms(reps, [&] { std::inclusive_scan(in.begin(), in.end(), out.begin()); });
+
+        double p_for = best_ms(reps, [&] { parallel_for(pool, size_t(0), n, [&](size_t i) { out[i] = body(in[i]); }, popts); });
+        double p_red = best_ms(reps, [&] { sink = parallel_reduce(pool, in.begin(), in.end(), 0.0, std::plus<>(), popts); });
+        double p_tr = best_ms(reps, [&] { parallel_transform(pool, in.begin(), in.end(), out.begin(), body, popts); });
+        double p_scan = best_ms(reps, [&] { parallel_scan(pool, in.begin(), in.end(), out.begin(), std::plus<>(), popts); });
+
+        std::cout << "parallel n=" << n << " (ms)\n"
+                  << "  for       serial=" << s_for << " pool=" << p_for << "\n"
+                  << "  reduce    serial=" << s_red << " pool=" << p_red << "\n"
+                  << "  transform serial=" << s_for << " pool=" << p_tr << "\n"
+                  << "  scan      serial=" << s_scan << " pool=" << p_scan << "\n";
+#ifdef ULLTP_BENCH_STD_PAR
+        double x_tr = best_ms(reps, [&] { std::transform(std::execution::par, in.begin(), in.end(), out.begin(), body); });
+        double x_red = best_ms(reps, [&] { sink = std::reduce(std::execution::par, in.begin(), in.end(), 0.0); });
+        double x_scan = best_ms(reps, [&] { std::inclusive_scan(std::execution::par, in.begin(), in.end(), out.begin()); });
+        std::cout << "  std::execution::par transform=" << x_tr << " reduce=" << x_red << " scan=" << x_scan << "\n";
+#endif
+        (void)sink;
+    }
+}
+
+// -------------------------- coro ---------------------------------
+// Per-hop cost of moving a computation onto a worker: co_await
+// pool.schedule() in a loop vs. a chain of submit() + future.get().
+#if defined(__cpp_impl_coroutine)
+static task<long> coro_hops(LowLatencyThreadPool& pool, size_t hops) {
+    long sum = 0;
+    for (size_t i = 0; i < hops; ++i) {
+        co_await pool.schedule();
+        sum += static_cast<long>(i);
+    }
+    co_return sum;
+}
+
+static task<long> coro_child(LowLatencyThreadPool& pool, long v) {
+    co_await pool.schedule();
+    co_return v;
+}
+
+static task<long> coro_fanout(LowLatencyThreadPool& pool, size_t rounds) {
+    long sum = 0;
+    for (size_t i = 0; i < rounds; ++i) {
+        auto [a, b] = co_await when_all(coro_child(pool, 1), coro_child(pool, 2));
+        sum += a + b;
+    }
+    co_return sum;
+}
+
+static void bench_coro(int argc, char** argv) {
+    unsigned threads = argc > 0 ? std::atoi(argv[0]) : 2;
+    size_t hops = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+    LowLatencyThreadPool pool(threads);
+
+    uint64_t t0 = now_ns();
+    long s1 = sync_wait(coro_hops(pool, hops));
+    uint64_t t1 = now_ns();
+    long s2 = 0;
+    for (size_t i = 0; i < hops; ++i) s2 += pool.submit([i] { return static_cast<long>(i); }).get();
+    uint64_t t2 = now_ns();
+    long s3 = sync_wait(coro_fanout(pool, hops / 2));
+    uint64_t t3 = now_ns();
+
+    std::cout << "coro co_await schedule " << (t1 - t0) / hops << "ns/hop\n"
+              << "coro submit+get        " << (t2 - t1) / hops << "ns/hop\n"
+              << "coro when_all(2)       " << (t3 - t2) / (hops / 2) << "ns/round\n";
+    if (s1 != s2 || s3 != static_cast<long>(hops / 2) * 3) std::cout << "coro: checksum mismatch\n";
+}
+#endif
+
+// -------------------------- strand -------------------------------
+// Per-key updates: mutex-per-key handlers posted straight to the pool (no
+// ordering, keys contend on their lock) vs KeyedExecutor (FIFO per key, no
+// lock). Run with many cold keys and with a few hot ones.
+struct MutexSlot {
+    std::mutex m;
+    uint64_t value = 0;
+};
+static std::vector<MutexSlot>* mutex_slots;
+static std::atomic<size_t> mutex_done;
+
+static void bench_strand(int argc, char** argv) {
+    unsigned threads = argc > 0 ? std::atoi(argv[0]) : 4;
+    size_t keys = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    size_t jobs = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000000;
+    PoolOptions opts;
+    opts.queue_capacity_pow2 = 1 << 16;
+    LowLatencyThreadPool pool(threads, opts);
+
+    for (size_t nkeys : {keys, size_t(8)}) {
+        std::vector<MutexSlot> slots(nkeys);
+        mutex_slots = &slots;
+        mutex_done.store(0, std::memory_order_relaxed);
+        auto locked = [](void* k) noexcept {  // key travels in the payload pointer
+            MutexSlot& s = (*mutex_slots)[reinterpret_cast<uintptr_t>(k)];
+            {
+                std::lock_guard<std::mutex> g(s.m);
+                ++s.value;
+            }
+            mutex_done.fetch_add(1, std::memory_order_relaxed);
+        };
+        uint64_t t0 = now_ns();
+        for (size_t i = 0; i < jobs; ++i) {
+            void* key = reinterpret_cast<void*>(static_cast<uintptr_t>(i % nkeys));
+            while (!pool.enqueue_raw(locked, key)) std::this_thread::yield();
+        }
+        while (mutex_done.load(std::memory_order_relaxed) < jobs) std::this_thread::yield();
+        uint64_t t1 = now_ns();
+
+        std::vector<uint64_t> values(nkeys, 0);
+        {
+            KeyedExecutor exec(pool, std::min<size_t>(nkeys * 4, 1 << 14));
+            for (size_t i = 0; i < jobs; ++i) {
+                size_t k = i % nkeys;
+                exec.post(k, [&values, k] { ++values[k]; });
+            }
+            exec.wait_idle();
+        }
+        uint64_t t2 = now_ns();
+
+        std::cout << "strand keys=" << nkeys << "\n"
+                  << "  mutex per key      " << (t1 - t0) / jobs << "ns/job (unordered)\n"
+                  << "  keyed strands      " << (t2 - t1) / jobs << "ns/job (FIFO per key)\n";
+        if (slots[0].value != values[0]) std::cout << "strand: checksum mismatch\n";
+    }
+}
+
+// ------------------------- overflow ------------------------------
+// A producer offers jobs faster than one worker can run them into a small
+// lane: producer-side enqueue latency and what each policy did.
+static void bench_overflow(int argc, char** argv) {
+    size_t jobs = argc > 0 ? std::strtoul(argv[0], nullptr, 10) : 20000;
+    uint64_t work_ns = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    const OverflowPolicy policies[] = {OverflowPolicy::Reject, OverflowPolicy::CallerRuns,
+                                       OverflowPolicy::Block, OverflowPolicy::DropOldest,
+                                       OverflowPolicy::Spill};
+    static uint64_t job_ns;
+    job_ns = work_ns;
+    auto job = [](void*) noexcept { spin_for_ns(job_ns); };
+    auto release = [](void*) noexcept {}; // makes the jobs droppable
+    std::vector<uint64_t> ns;
+    for (OverflowPolicy policy : policies) {
+        PoolOptions opts;
+        opts.queue_capacity_pow2 = 64;
+        opts.overflow = policy;
+        opts.block_timeout = std::chrono::microseconds(20);
+        LowLatencyThreadPool pool(1, opts);
+
+        ns.clear();
+        size_t accepted_jobs = 0;
+        for (size_t i = 0; i < jobs; ++i) {
+            uint64_t t0 = now_ns();
+            SubmitStatus st = pool.enqueue(job, nullptr, release);
+            ns.push_back(now_ns() - t0);
+            accepted_jobs += accepted(st);
+        }
+        pool.shutdown();
+
+        std::string label = std::string("overflow ") + to_string(policy);
+        label.resize(20, ' ');
+        print_percentiles(label.c_str(), ns);
+        LaneStats st = pool.lane_stats(0);
+        std::cout << "                     accepted=" << accepted_jobs << " full=" << st.full
+                  << " rejected=" << st.rejected << " inline=" << st.ran_inline
+                  << " timed_out=" << st.timed_out << " dropped=" << st.dropped
+                  << " spilled=" << st.spilled << "\n";
+    }
+}
+
+// -------------------------- scale --------------------------------
+// Autoscaling through a quiet / burst / quiet day: worker count and scale
+// events after each phase.
+static void bench_scale(int argc, char** argv) {
+    unsigned max_threads = argc > 0 ? std::atoi(argv[0]) : 4;
+    unsigned burst_ms = argc > 1 ? std::atoi(argv[1]) : 300;
+    PoolOptions opts;
+    opts.max_threads = max_threads;
+    opts.queue_capacity_pow2 = 1 << 14;
+    opts.wait = WaitStrategy::SpinPark;
+    opts.autoscale.enabled = true;
+    opts.autoscale.grow_depth = 16;
+    opts.autoscale.idle_retire = std::chrono::milliseconds(100);
+    LowLatencyThreadPool pool(1, opts);
+
+    auto report = [&](const char* phase) {
+        ScaleStats st = pool.scale_stats();
+        std::cout << "scale " << phase << " workers=" << st.active << "/" << st.capacity
+                  << " started=" << st.started << " retired=" << st.retired << "\n";
+    };
+    auto job = [](void*) noexcept { spin_for_ns(20000); };
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(burst_ms));
+    report("quiet   ");
+    uint64_t end = now_ns() + uint64_t(burst_ms) * 1000000;
+    while (now_ns() < end)
+        if (!pool.enqueue_raw(job, nullptr)) std::this_thread::yield();
+    report("burst   ");
+    std::this_thread::sleep_for(std::chrono::milliseconds(burst_ms * 3));
+    report("cooldown");
+}
+
+// --------------------------- fork --------------------------------
+// Recursive fib(n) with a serial cutoff: serial, task_group fork-join, and
+// nested submit() + pool.wait(future). Plain future.get() inside workers
+// would deadlock once every worker waits, so it isn't run.
+static long fib_serial(int n) { return n < 2 ? n : fib_serial(n - 1) + fib_serial(n - 2); }
+
+static long fib_group(LowLatencyThreadPool& pool, int n, int cutoff) {
+    if (n <= cutoff) return fib_serial(n);
+    long a = 0;
+    task_group g(pool);
+    g.run([&] { a = fib_group(pool, n - 1, cutoff); });
+    long b = fib_group(pool, n - 2, cutoff);
+    g.wait();
+    return a + b;
+}
+
+static long fib_future(LowLatencyThreadPool& pool, int n, int cutoff) {
+    if (n <= cutoff) return fib_serial(n);
+    auto a = pool.submit([&pool, n, cutoff] { return fib_future(pool, n - 1, cutoff); });
+    long b = fib_future(pool, n - 2, cutoff);
+    return pool.wait(a) + b;
+}
+
+static void bench_fork(int argc, char** argv) {
+    unsigned threads = argc > 0 ? std::atoi(argv[0]) : 4;
+    int n = argc > 1 ? std::atoi(argv[1]) : 32;
+    int cutoff = argc > 2 ? std::atoi(argv[2]) : 18;
+    LowLatencyThreadPool pool(threads);
+    long r0 = 0, r1 = 0, r2 = 0;
+    double serial = best_ms(3, [&] { r0 = fib_serial(n); });
+    double group = best_ms(3, [&] { r1 = fib_group(pool, n, cutoff); });
+    double fut = best_ms(3, [&] { r2 = fib_future(pool, n, cutoff); });
+    std::cout << "fork fib(" << n << ") cutoff " << cutoff << "\n"
+              << "  serial             " << serial << "ms\n"
+              << "  task_group         " << group << "ms\n"
+              << "  submit+pool.wait   " << fut << "ms\n";
+    if (r0 != r1 || r0 != r2) std::cout << "fork: result mismatch\n";
+}
+
+// -------------------------- trace --------------------------------
+// Cost of one trace event on the calling thread, and raw-path throughput
+// with the hooks built in or out (-DULLTP_ENABLE_TRACE=1).
+static void bench_trace(int argc, char** argv) {
+    size_t events = argc > 0 ? std::strtoul(argv[0], nullptr, 10) : 10000000;
+    size_t jobs = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    ULLTP_TRACE_THREAD("bench");
+    uint64_t t0 = now_ns();
+    for (size_t i = 0; i < events; ++i) ULLTP_TRACE(Mark, i);
+    uint64_t t1 = now_ns();
+
+    LowLatencyThreadPool pool(2, PoolOptions{});
+    std::atomic<size_t> done{0};
+    auto job = [](void* p) noexcept {
+        static_cast<std::atomic<size_t>*>(p)->fetch_add(1, std::memory_order_relaxed);
+    };
+    uint64_t t2 = now_ns();
+    for (size_t i = 0; i < jobs; ++i)
+        while (!pool.enqueue_raw(job, &done)) cpu_relax();
+    while (done.load(std::memory_order_relaxed) < jobs) std::this_thread::yield();
+    uint64_t t3 = now_ns();
+
+    std::cout << "trace " << (ULLTP_ENABLE_TRACE ? "on " : "off") << "            "
+              << double(t1 - t0) / events << "ns/event, " << (t3 - t2) / jobs << "ns/job\n";
+}
+
+// --------------------------- numa --------------------------------
+// Raw-path throughput on the real topology and on 'fake' pretend nodes,
+// with where the jobs went. On one socket this only measures the extra
+// routing; run on a dual-socket host for the local-memory effect.
+static void bench_numa(int argc, char** argv) {
+    unsigned fake = argc > 0 ? std::atoi(argv[0]) : 2;
+    unsigned per_node = argc > 1 ? std::atoi(argv[1]) : 2;
+    size_t jobs = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000;
+    for (unsigned nodes : {0u, fake}) {
+        NumaOptions opts;
+        opts.fake_nodes = nodes;
+        opts.threads_per_node = per_node;
+        NumaThreadPool pool(opts);
+
+        std::atomic<size_t> done{0};
+        auto job = [](void* p) noexcept {
+            static_cast<std::atomic<size_t>*>(p)->fetch_add(1, std::memory_order_relaxed);
+        };
+        uint64_t t0 = now_ns();
+        for (size_t i = 0; i < jobs; ++i)
+            while (!pool.enqueue_raw(job, &done)) cpu_relax();
+        while (done.load(std::memory_order_relaxed) < jobs) std::this_thread::yield();
+        uint64_t t1 = now_ns();
+
+        NumaStats st = pool.stats();
+        std::cout << "numa nodes=" << pool.nodes() << (nodes > 1 ? " (fake)" : "       ")
+                  << "   " << (t1 - t0) / jobs << "ns/job local=" << st.local
+                  << " remote=" << st.remote << " stolen=" << st.stolen << "\n";
+    }
+}
+
+// ------------------------- metrics -------------------------------
+// Raw-path throughput with whatever ULLTP_ENABLE_METRICS the binary was built
+// with (build twice to see the overhead), then the pool's own snapshot.
+static void bench_metrics(int argc, char** argv) {
+    unsigned threads = argc > 0 ? std::atoi(argv[0]) : 2;
+    size_t jobs = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    LowLatencyThreadPool pool(threads, PoolOptions{});
+
+    std::atomic<size_t> done{0};
+    auto job = [](void* p) noexcept {
+        static_cast<std::atomic<size_t>*>(p)->fetch_add(1, std::memory_order_relaxed);
+    };
+    uint64_t t0 = now_ns();
+    for (size_t i = 0; i < jobs; ++i)
+        while (!pool.enqueue_raw(job, &done)) cpu_relax();
+    while (done.load(std::memory_order_relaxed) < jobs) std::this_thread::yield();
+    uint64_t t1 = now_ns();
+
+    std::cout << "metrics " << (LowLatencyThreadPool::metrics_enabled ? "on " : "off")
+              << "          " << (t1 - t0) / jobs << "ns/job\n";
+    PoolMetrics m = pool.snapshot();
+    std::cout << "                     full enqueues=" << m.full_enqueues << '\n';
+    if (!m.enabled) return;
+    for (size_t w = 0; w < m.workers.size(); ++w) {
+        const WorkerStats& st = m.workers[w];
+        std::cout << "                     worker " << w << " jobs=" << st.jobs
+                  << " spins=" << st.spins << " yields=" << st.yields << " parks=" << st.parks
+                  << " wait p50/p99=" << st.queue_wait.percentile_ns(0.50) << '/'
+                  << st.queue_wait.percentile_ns(0.99) << "ns exec p99="
+                  << st.exec.percentile_ns(0.99) << "ns\n";
+    }
+}
+
+// -------------------------- queue --------------------------------
+// Raw MPMCBoundedQueue<Job> throughput per cell layout: 'threads'
+// producers and as many consumers moving 'ops' jobs through a small ring.
+template <class Layout>
+static double queue_rate(unsigned threads, size_t ops, size_t capacity) {
+    MPMCBoundedQueue<Job, Layout> q(capacity);
+    std::atomic<size_t> consumed{0};
+    std::vector<std::thread> ts;
+    uint64_t t0 = now_ns();
+    for (unsigned t = 0; t < threads; ++t) {
+        ts.emplace_back([&, t] {
+            Job j;
+            for (size_t i = t; i < ops; i += threads)
+                while (!q.enqueue(j)) std::this_thread::yield();
+        });
+        ts.emplace_back([&] {
+            Job j;
+            while (consumed.load(std::memory_order_relaxed) < ops) {
+                if (q.dequeue(j)) consumed.fetch_add(1, std::memory_order_relaxed);
+                else std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& th : ts) th.join();
+    return ops * 1e9 / double(now_ns() - t0);
+}
+
+static void bench_queue(int argc, char** argv) {
+    unsigned threads = argc > 0 ? std::atoi(argv[0]) : 2;
+    size_t ops = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4000000;
+    size_t capacity = 1024;
+    std::cout << "queue padded         " << queue_rate<PaddedCells>(threads, ops, capacity) / 1e6
+              << "M ops/s (" << capacity * 64 / 1024 << "KB cells)\n";
+    std::cout << "queue dense          " << queue_rate<DenseCells>(threads, ops, capacity) / 1e6
+              << "M ops/s (" << capacity * (sizeof(Job) + 8) / 1024 << "KB cells)\n";
+    std::cout << "queue split          " << queue_rate<SplitCells>(threads, ops, capacity) / 1e6
+              << "M ops/s (" << capacity * (sizeof(Job) + 8) / 1024 << "KB cells)\n";
+}
+
+// --------------------------- mpsc --------------------------------
+// One consumer draining 'producers' threads, 'ops' jobs in total: the
+// MPMC lane queue against the bounded and the intrusive MPSC queues and
+// FanInQueue's per-producer lanes. MPSC consumers take batches of 64.
+struct JobNode : MPSCHook {
+    Job job;
+};
+
+template <class Q, class Produce, class Consume>
+static double fan_in_rate(unsigned producers, size_t ops, Q& q, Produce produce, Consume consume) {
+    std::vector<std::thread> ts;
+    uint64_t t0 = now_ns();
+    for (unsigned p = 0; p < producers; ++p)
+        ts.emplace_back([&, p] {
+            for (size_t i = p; i < ops; i += producers)
+                while (!produce(q, i)) std::this_thread::yield();
+        });
+    for (size_t done = 0; done < ops;) {
+        size_t n = consume(q);
+        if (n == 0) std::this_thread::yield();
+        done += n;
+    }
+    for (auto& th : ts) th.join();
+    return ops * 1e9 / double(now_ns() - t0);
+}
+
+// FanInQueue: each producer registers its own SPSC lane.
+static double fan_in_lanes_rate(unsigned producers, size_t ops, FanInPolling polling) {
+    FanInQueue<Job> q(producers, 1024 / producers, polling);
+    std::vector<std::thread> ts;
+    uint64_t t0 = now_ns();
+    for (unsigned p = 0; p < producers; ++p)
+        ts.emplace_back([&, p] {
+            auto lane = q.registerProducer();
+            for (size_t i = p; i < ops; i += producers)
+                while (!lane.enqueue(Job{})) std::this_thread::yield();
+        });
+    Job batch[64];
+    for (size_t done = 0; done < ops;) {
+        size_t n = q.dequeue_bulk(batch, 64);
+        if (n == 0) std::this_thread::yield();
+        done += n;
+    }
+    for (auto& th : ts) th.join();
+    return ops * 1e9 / double(now_ns() - t0);
+}
+
+static void bench_mpsc(int argc, char** argv) {
+    size_t ops = argc > 0 ? std::strtoul(argv[0], nullptr, 10) : 4000000;
+    size_t capacity = 1024;
+    std::vector<JobNode> nodes(ops);
+    for (unsigned producers : {2u, 4u, 8u, 16u}) {
+        MPMCBoundedQueue<Job> mpmc(capacity);
+        double mpmc_rate = fan_in_rate(producers, ops, mpmc,
+            [](MPMCBoundedQueue<Job>& q, size_t) { return q.enqueue(Job{}); },
+            [](MPMCBoundedQueue<Job>& q) { Job j; return size_t(q.dequeue(j)); });
+
+        BoundedMPSCQueue<Job> bounded(capacity);
+        double bounded_rate = fan_in_rate(producers, ops, bounded,
+            [](BoundedMPSCQueue<Job>& q, size_t) { return q.enqueue(Job{}); },
+            [](BoundedMPSCQueue<Job>& q) { Job batch[64]; return q.dequeue_bulk(batch, 64); });
+
+        IntrusiveMPSCQueue<JobNode> intrusive;
+        double intrusive_rate = fan_in_rate(producers, ops, intrusive,
+            [&](IntrusiveMPSCQueue<JobNode>& q, size_t i) { q.enqueue(&nodes[i]); return true; },
+            [](IntrusiveMPSCQueue<JobNode>& q) { JobNode* batch[64]; return q.dequeue_bulk(batch, 64); });
+
+        std::cout << "mpsc " << producers << "->1  mpmc " << mpmc_rate / 1e6 << "M  bounded "
+                  << bounded_rate / 1e6 << "M  intrusive " << intrusive_rate / 1e6 << "M  fan-in rr "
+                  << fan_in_lanes_rate(producers, ops, FanInPolling::RoundRobin) / 1e6 << "M  fan-in bitmap "
+                  << fan_in_lanes_rate(producers, ops, FanInPolling::Bitmap) / 1e6 << "M ops/s\n";
+    }
+}
+
+// --------------------------- spsc --------------------------------
+// One producer, one consumer, 'ops' jobs: the fixed LockFreeQueue ring
+// against UnboundedSPSCQueue with segments of the same size. The bounded
+// producer yields when full, the unbounded one grows instead.
+template <class Q, class Produce>
+static double spsc_rate(size_t ops, Q& q, Produce produce) {
+    uint64_t t0 = now_ns();
+    std::thread producer([&] {
+        for (size_t i = 0; i < ops; ++i) produce(q);
+    });
+    Job j;
+    for (size_t done = 0; done < ops;) {
+        if (q.dequeue(j)) ++done;
+        else std::this_thread::yield();
+    }
+    producer.join();
+    return ops * 1e9 / double(now_ns() - t0);
+}
+
+static void bench_spsc(int argc, char** argv) {
+    size_t ops = argc > 0 ? std::strtoul(argv[0], nullptr, 10) : 10000000;
+    size_t capacity = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1024;
+    for (int run = 0; run < 2; ++run) {
+        LockFreeQueue<Job> ring(capacity);
+        double ring_rate = spsc_rate(ops, ring, [](LockFreeQueue<Job>& q) {
+            while (!q.enqueue(Job{})) std::this_thread::yield();
+        });
+        UnboundedSPSCQueue<Job> chain(capacity);
+        double chain_rate = spsc_rate(ops, chain, [](UnboundedSPSCQueue<Job>& q) { q.enqueue(Job{}); });
+        // A second pass over a warmed-up chain: no allocation any more.
+        size_t warmed = chain.segments();
+        double warm_rate = spsc_rate(ops, chain, [](UnboundedSPSCQueue<Job>& q) { q.enqueue(Job{}); });
+        std::cout << "spsc ring " << ring_rate / 1e6 << "M  segmented " << chain_rate / 1e6
+                  << "M  warmed " << warm_rate / 1e6 << "M ops/s (" << warmed << " -> "
+                  << chain.segments() << " segments)\n";
+    }
+}
+
+// -------------------------- notify -------------------------------
+// EventCount on a LockFreeQueue: what notify_one() adds to the producer
+// while nobody waits, and send-to-receive latency of a consumer woken every
+// gap_us (sleeping, spinning first, and a mutex + condition_variable
+// queue for comparison), with the cpu the consumer burnt meanwhile.
+static void bench_notify(int argc, char** argv) {
+    size_t samples = argc > 0 ? std::strtoul(argv[0], nullptr, 10) : 2000;
+    unsigned gap_us = argc > 1 ? std::atoi(argv[1]) : 200;
+
+    {
+        constexpr size_t ops = 20000000;
+        LockFreeQueue<Job> q(1024);
+        EventCount events;
+        Job j;
+        uint64_t t0 = now_ns();
+        for (size_t i = 0; i < ops; ++i) { q.enqueue(j); q.dequeue(j); }
+        uint64_t t1 = now_ns();
+        for (size_t i = 0; i < ops; ++i) { q.enqueue(j); events.notify_one(); q.dequeue(j); }
+        uint64_t t2 = now_ns();
+        std::cout << "notify producer cost  " << double(t2 - t1 - (t1 - t0)) / ops
+                  << "ns per enqueue with no waiter (enqueue+dequeue " << double(t1 - t0) / ops << "ns)\n";
+    }
+
+    std::vector<uint64_t> ns;
+    auto run = [&](const char* label, auto send, auto receive) {
+        ns.clear();
+        double cpu0 = process_cpu_seconds();
+        std::thread consumer([&] {
+            for (size_t i = 0; i < samples; ++i) {
+                uint64_t sent = receive();
+                ns.push_back(now_ns() - sent);
+            }
+        });
+        for (size_t i = 0; i < samples; ++i) {
+            std::this_thread::sleep_for(std::chrono::microseconds(gap_us));
+            send(now_ns());
+        }
+        consumer.join();
+        double cpu = process_cpu_seconds() - cpu0;
+        print_percentiles(label, ns);
+        std::cout << "      consumer+producer cpu " << cpu * 1e3 << "ms over "
+                  << samples * gap_us / 1000 << "ms\n";
+    };
+
+    for (unsigned spins : {0u, 1u << 14}) {
+        LockFreeQueue<uint64_t> q(1024);
+        EventCount events;
+        run(spins ? "notify eventcount+spin" : "notify eventcount     ",
+            [&](uint64_t t) { q.enqueue(t); events.notify_one(); },
+            [&] { uint64_t t; events.await([&] { return q.dequeue(t); }, spins); return t; });
+    }
+    {
+        std::mutex m;
+        std::condition_variable cv;
+        std::queue<uint64_t> q;
+        run("notify mutex+cv       ",
+            [&](uint64_t t) { { std::lock_guard<std::mutex> lock(m); q.push(t); } cv.notify_one(); },
+            [&] {
+                std::unique_lock<std::mutex> lock(m);
+                cv.wait(lock, [&] { return !q.empty(); });
+                uint64_t t = q.front();
+                q.pop();
+                return t;
+            });
+    }
+}
+
+// ------------------------- driver --------------------------------
+struct Bench {
+    const char* name;
+    const char* usage;
+    void (*run)(int, char**);
+};
+
+static const Bench benches[] = {
+    {"jitter", "jitter [cpu,cpu...] [rt_priority] [samples]", bench_jitter},
+    {"wait", "wait [threads] [gap_us] [samples]", bench_wait},
+    {"lanes", "lanes [threads] [probes]", bench_lanes},
+    {"timers", "timers [count] [window_ms] [threads]", bench_timers},
+    {"graph", "graph [threads] [ticks] [work_ns]", bench_graph},
+    {"parallel", "parallel [threads] [max_n] [grain]", bench_parallel},
+    {"strand", "strand [threads] [keys] [jobs]", bench_strand},
+    {"overflow", "overflow [jobs] [work_ns]", bench_overflow},
+    {"scale", "scale [max_threads] [burst_ms]", bench_scale},
+    {"fork", "fork [threads] [n] [cutoff]", bench_fork},
+    {"trace", "trace [events] [jobs]", bench_trace},
+    {"numa", "numa [fake_nodes] [threads_per_node] [jobs]", bench_numa},
+    {"metrics", "metrics [threads] [jobs]", bench_metrics},
+    {"queue", "queue [threads] [ops]", bench_queue},
+    {"mpsc", "mpsc [ops]", bench_mpsc},
+    {"spsc", "spsc [ops] [capacity]", bench_spsc},
+    {"notify", "notify [samples] [gap_us]", bench_notify},
+#if defined(__cpp_impl_coroutine)
+    {"coro", "coro [threads] [hops]", bench_coro},
+#endif
+};
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        for (const Bench& b : benches) {
+            std::cout << "== " << b.name << "\n";
+            b.run(0, nullptr);
+        }
+        return 0;
+    }
+    for (const Bench& b : benches) {
+        if (std::strcmp(b.name, argv[1]) == 0) {
+            b.run(argc - 2, argv + 2);
+            return 0;
+        }
+    }
+    std::cout << "usage:\n";
+    for (const Bench& b : benches) std::cout << "  " << argv[0] << " " << b.usage << "\n";
+    return 1;
+}
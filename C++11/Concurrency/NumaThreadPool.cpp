@@ -0,0 +1,31 @@
+#include <iostream>
+
+#include "NumaThreadPool.hpp"
+
+int main() {
+    for (const NumaNode& n : numa_topology()) {
+        std::cout << "node" << n.id << " cpus:";
+        for (int c : n.cpus) std::cout << ' ' << c;
+        std::cout << "\n";
+    }
+
+    // Two pretend nodes so the cross-node paths run on any machine.
+    NumaOptions opts;
+    opts.fake_nodes = 2;
+    opts.threads_per_node = 2;
+    opts.pool.name_prefix = "numa";
+    NumaThreadPool pool(opts);
+
+    auto fut = pool.submit([&pool] { return pool.current_node(); });
+    std::cout << pool.nodes() << " nodes, job ran on node " << fut.get() << "\n";
+
+    std::atomic<int> done{0};
+    for (int i = 0; i < 10000; ++i) {
+        while (!pool.enqueue_raw([](void* p) noexcept {
+            static_cast<std::atomic<int>*>(p)->fetch_add(1, std::memory_order_relaxed);
+        }, &done)) std::this_thread::yield();
+    }
+    while (done.load() < 10000) std::this_thread::yield();
+    NumaStats st = pool.stats();
+    std::cout << "local=" << st.local << " remote=" << st.remote << " stolen=" << st.stolen << "\n";
+}
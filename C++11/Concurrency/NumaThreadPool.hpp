@@ -0,0 +1,249 @@
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LowLatencyThreadPool.hpp"
+
+// --------------------- NUMA-aware pool (one pool per node) ---------------------
+// One LowLatencyThreadPool per NUMA node, its workers pinned to that node's
+// cpus. Each node pool is constructed on a thread pinned to the node, so its
+// queue buffers are first-touched in node-local memory.
+//
+// Submitters enqueue on the node they are running on (sched_getcpu()), so a
+// payload they just allocated is consumed on the same socket; if that lane
+// is full the job goes to the other nodes in order. Idle workers steal from
+// the other nodes through the pools' idle hook (so SpinYield, Sleep or
+// BusySpin; parked SpinPark workers don't steal).
+//
+// Topology comes from /sys/devices/system/node. Without it, or on a single
+// node, this is one ordinary pool. NumaOptions::fake_nodes splits the cpus
+// into N pretend nodes to exercise the multi-node paths on any machine.
+
+struct NumaNode {
+    int id = 0;
+    std::vector<int> cpus;
+};
+
+// "0-3,8,10-11" -> {0,1,2,3,8,10,11}
+inline std::vector<int> parse_cpulist(const std::string& list) {
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t end = list.find(',', pos);
+        if (end == std::string::npos) end = list.size();
+        std::string item = list.substr(pos, end - pos);
+        size_t dash = item.find('-');
+        if (!item.empty() && item[0] >= '0' && item[0] <= '9') {
+            int lo = std::atoi(item.c_str());
+            int hi = dash == std::string::npos ? lo : std::atoi(item.c_str() + dash + 1);
+            for (int c = lo; c <= hi; ++c) cpus.push_back(c);
+        }
+        pos = end + 1;
+    }
+    return cpus;
+}
+
+// Online nodes that have cpus; empty if /sys isn't there.
+inline std::vector<NumaNode> numa_topology() {
+    std::vector<NumaNode> nodes;
+    std::string online;
+    std::ifstream f("/sys/devices/system/node/online");
+    if (!(f >> online)) return nodes;
+    for (int id : parse_cpulist(online)) {
+        std::ifstream c("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+        std::string list;
+        if (!(c >> list)) continue;
+        NumaNode n;
+        n.id = id;
+        n.cpus = parse_cpulist(list);
+        if (!n.cpus.empty()) nodes.push_back(std::move(n));
+    }
+    return nodes;
+}
+
+struct NumaOptions {
+    PoolOptions pool;                // per node; cpus/name_prefix are set per node
+    unsigned threads_per_node = 0;   // 0 = one per cpu of the node
+    unsigned fake_nodes = 0;         // >1: split the cpus into this many nodes
+    bool pin = true;                 // pin workers to their node's cpus
+    bool steal = true;               // idle workers run other nodes' jobs
+};
+
+struct NumaStats {
+    uint64_t local = 0;      // enqueued on the submitter's node
+    uint64_t remote = 0;     // local lane full, placed on another node
+    uint64_t stolen = 0;     // jobs run by another node's idle worker
+};
+
+class NumaThreadPool {
+public:
+    explicit NumaThreadPool(const NumaOptions& opts = {}) {
+        nodes_ = numa_topology();
+        if (nodes_.empty()) {
+            NumaNode all;
+            for (unsigned c = 0; c < std::max(1u, std::thread::hardware_concurrency()); ++c)
+                all.cpus.push_back(static_cast<int>(c));
+            nodes_.push_back(std::move(all));
+        }
+        if (opts.fake_nodes > 1) nodes_ = split(nodes_, opts.fake_nodes);
+
+        for (size_t n = 0; n < nodes_.size(); ++n)
+            for (int c : nodes_[n].cpus) {
+                if (c >= static_cast<int>(cpu_node_.size())) cpu_node_.resize(c + 1, 0);
+                cpu_node_[c] = static_cast<unsigned>(n);
+            }
+
+        pools_.resize(nodes_.size());
+        for (size_t n = 0; n < nodes_.size(); ++n) {
+            PoolOptions po = opts.pool;
+            po.cpus = opts.pin ? nodes_[n].cpus : std::vector<int>{};
+            po.name_prefix = opts.pool.name_prefix + std::to_string(n);
+            unsigned threads = opts.threads_per_node ? opts.threads_per_node
+                                                     : static_cast<unsigned>(nodes_[n].cpus.size());
+            // Build on a thread running on the node so the queues are local.
+            std::thread builder([&, n, threads] {
+                pin_self(nodes_[n].cpus);
+                pools_[n] = std::make_unique<LowLatencyThreadPool>(threads, po);
+            });
+            builder.join();
+        }
+        if (opts.steal && pools_.size() > 1) {
+            steal_ctx_.reset(new StealCtx[pools_.size()]);
+            for (size_t n = 0; n < pools_.size(); ++n) {
+                steal_ctx_[n] = StealCtx{this, static_cast<unsigned>(n)};
+                pools_[n]->set_idle_hook(&NumaThreadPool::steal, &steal_ctx_[n]);
+            }
+        }
+    }
+
+    ~NumaThreadPool() { shutdown(); }
+
+    void shutdown() noexcept {
+        for (auto& p : pools_) p->set_idle_hook(nullptr, nullptr);
+        for (auto& p : pools_) p->shutdown();
+    }
+
+    unsigned nodes() const noexcept { return static_cast<unsigned>(pools_.size()); }
+    const NumaNode& node(unsigned n) const { return nodes_.at(n); }
+    LowLatencyThreadPool& node_pool(unsigned n) { return *pools_.at(n); }
+
+    // Node of the cpu the caller is running on (0 if unknown).
+    unsigned current_node() const noexcept {
+#if defined(__linux__)
+        int cpu = sched_getcpu();
+        if (cpu >= 0 && cpu < static_cast<int>(cpu_node_.size())) return cpu_node_[cpu];
+#endif
+        return 0;
+    }
+
+    // Local node first, then the others; false if every node's lane is full.
+    bool enqueue_raw(Job::Fn fn, void* data, void (*deleter)(void*) = nullptr,
+                     unsigned lane = 0) noexcept {
+        return enqueue_from(current_node(), fn, data, deleter, lane);
+    }
+
+    bool enqueue_raw_on(unsigned node, Job::Fn fn, void* data, void (*deleter)(void*) = nullptr,
+                        unsigned lane = 0) noexcept {
+        return pools_[node % pools_.size()]->enqueue_raw(fn, data, deleter, lane);
+    }
+
+    // Like LowLatencyThreadPool::submit(); when every node is full the local
+    // pool's overflow policy decides.
+    template <class F, class... Args>
+    auto submit(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>> {
+        using R = std::invoke_result_t<F, Args...>;
+        using Packaged = std::packaged_task<R()>;
+        auto* pkg = new Packaged(std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+        std::future<R> fut = pkg->get_future();
+        auto run = [](void* p) noexcept { (*static_cast<Packaged*>(p))(); };
+        auto del = [](void* p) noexcept { delete static_cast<Packaged*>(p); };
+        unsigned home = current_node();
+        if (enqueue_from(home, run, pkg, del, 0)) return fut;
+        SubmitStatus st = pools_[home]->enqueue(run, pkg, del, 0);
+        if (!accepted(st)) {
+            delete pkg;
+            throw std::system_error(std::make_error_code(std::errc::resource_unavailable_try_again),
+                                    "NumaThreadPool: all nodes full");
+        }
+        return fut;
+    }
+
+    NumaStats stats() const noexcept {
+        NumaStats s;
+        s.local = local_.load(std::memory_order_relaxed);
+        s.remote = remote_.load(std::memory_order_relaxed);
+        s.stolen = stolen_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    struct StealCtx {
+        NumaThreadPool* self;
+        unsigned node;
+    };
+
+    static std::vector<NumaNode> split(const std::vector<NumaNode>& real, unsigned parts) {
+        std::vector<int> cpus;
+        for (const NumaNode& n : real) cpus.insert(cpus.end(), n.cpus.begin(), n.cpus.end());
+        std::vector<NumaNode> out(parts);
+        for (unsigned p = 0; p < parts; ++p) out[p].id = static_cast<int>(p);
+        if (cpus.size() < parts) {
+            for (NumaNode& n : out) n.cpus = cpus; // too few cpus: share them
+        } else {
+            for (size_t i = 0; i < cpus.size(); ++i) out[i * parts / cpus.size()].cpus.push_back(cpus[i]);
+        }
+        return out;
+    }
+
+    static void pin_self(const std::vector<int>& cpus) noexcept {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c : cpus) CPU_SET(c, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set); // best effort
+#else
+        (void)cpus;
+#endif
+    }
+
+    bool enqueue_from(unsigned home, Job::Fn fn, void* data, void (*deleter)(void*),
+                      unsigned lane) noexcept {
+        const unsigned n = nodes();
+        for (unsigned i = 0; i < n; ++i) {
+            if (pools_[(home + i) % n]->enqueue_raw(fn, data, deleter, lane)) {
+                (i == 0 ? local_ : remote_).fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Idle hook of node 'node': run one job from the nearest other node.
+    static bool steal(void* p) noexcept {
+        auto* ctx = static_cast<StealCtx*>(p);
+        NumaThreadPool& self = *ctx->self;
+        const unsigned n = self.nodes();
+        for (unsigned i = 1; i < n; ++i) {
+            if (self.pools_[(ctx->node + i) % n]->run_one()) {
+                self.stolen_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<NumaNode> nodes_;
+    std::vector<unsigned> cpu_node_;
+    std::vector<std::unique_ptr<LowLatencyThreadPool>> pools_;
+    std::unique_ptr<StealCtx[]> steal_ctx_;
+    alignas(ULLTP_CACHELINE) std::atomic<uint64_t> local_{0};
+    std::atomic<uint64_t> remote_{0};
+    alignas(ULLTP_CACHELINE) std::atomic<uint64_t> stolen_{0};
+};
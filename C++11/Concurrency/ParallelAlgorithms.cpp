@@ -0,0 +1,25 @@
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+#include "ParallelAlgorithms.hpp"
+
+int main() {
+    LowLatencyThreadPool pool(4);
+    ParallelOptions opts;
+    opts.grain = 1 << 14;
+
+    std::vector<double> v(1 << 20);
+    parallel_for(pool, size_t(0), v.size(), [&](size_t i) { v[i] = 0.5 * i; }, opts);
+
+    double sum = parallel_reduce(pool, v.begin(), v.end(), 0.0, std::plus<>(), opts);
+    std::cout << "sum=" << sum << " expected=" << 0.5 * (double(v.size()) * (v.size() - 1) / 2) << "\n";
+
+    std::vector<double> sq(v.size());
+    parallel_transform(pool, v.begin(), v.end(), sq.begin(), [](double x) { return x * x; }, opts);
+    std::cout << "sq[10]=" << sq[10] << "\n";
+
+    std::vector<long> ones(1000003, 1), prefix(ones.size());
+    parallel_scan(pool, ones.begin(), ones.end(), prefix.begin(), std::plus<>(), opts);
+    std::cout << "prefix.back()=" << prefix.back() << "\n";
+}
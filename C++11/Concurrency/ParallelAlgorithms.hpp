@@ -0,0 +1,250 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "LowLatencyThreadPool.hpp"
+
+// ------------- Data-parallel algorithms over a thread pool -------------
+// parallel_for / parallel_reduce / parallel_transform / parallel_scan run on
+// the workers of an existing pool instead of an implicit global one (as
+// std::execution::par does), so they share pinned cores and lanes.
+//
+// Work is handed out from one atomic cursor in guided chunks: each claim
+// takes max(grain, remaining / (2 * participants)), so chunks start large
+// and shrink towards the end for load balance. The calling thread is a
+// participant; helpers are posted to the pool and simply find nothing left
+// if they start late. Ranges of at most one grain run inline on the caller.
+//
+// Works with anything exposing LowLatencyThreadPool's enqueue_raw(), or
+// with a plain submit(F) pool such as ThreadPool.
+
+struct ParallelOptions {
+    size_t grain = 4096;           // minimum elements per chunk
+    unsigned max_helpers = ~0u;    // pool workers to enlist (capped at pool size)
+    unsigned lane = 0;             // LowLatencyThreadPool lane for helpers
+};
+
+namespace parallel_detail {
+
+template <class Pool, class = void>
+struct has_enqueue_raw : std::false_type {};
+template <class Pool>
+struct has_enqueue_raw<Pool, std::void_t<decltype(std::declval<Pool&>().enqueue_raw(
+    std::declval<Job::Fn>(), nullptr, nullptr, 0u))>> : std::true_type {};
+
+template <class Pool, class = void>
+struct has_size : std::false_type {};
+template <class Pool>
+struct has_size<Pool, std::void_t<decltype(std::declval<const Pool&>().size())>> : std::true_type {};
+
+template <class Pool>
+unsigned pool_workers(const Pool& pool) {
+    if constexpr (has_size<Pool>::value) return static_cast<unsigned>(pool.size());
+    else return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Shared between the caller and its helpers. Heap-allocated and
+// ref-counted because a helper may be dequeued after the call returned;
+// such a helper finds the cursor exhausted and never touches 'body'.
+struct ChunkState {
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    std::atomic<uint32_t> refs{1};
+    size_t end = 0;
+    size_t grain = 1;
+    size_t parts = 1;
+    void* body = nullptr;
+    void (*invoke)(void*, size_t, size_t) = nullptr;
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+
+    bool claim(size_t& b, size_t& e) noexcept {
+        size_t cur = next.load(std::memory_order_relaxed);
+        for (;;) {
+            if (cur >= end) return false;
+            size_t rem = end - cur;
+            size_t c = std::min(rem, std::max(grain, rem / (2 * parts)));
+            if (next.compare_exchange_weak(cur, cur + c, std::memory_order_relaxed)) {
+                b = cur;
+                e = cur + c;
+                return true;
+            }
+        }
+    }
+
+    void work() noexcept {
+        size_t b, e;
+        while (claim(b, e)) {
+            try {
+                invoke(body, b, e);
+            } catch (...) {
+                if (!failed.exchange(true, std::memory_order_acq_rel)) error = std::current_exception();
+                // Retire everything not yet claimed so the caller stops waiting.
+                size_t rest = next.exchange(end, std::memory_order_relaxed);
+                if (rest < end) done.fetch_add(end - rest, std::memory_order_relaxed);
+            }
+            done.fetch_add(e - b, std::memory_order_release);
+        }
+    }
+
+    void release() noexcept {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+    }
+
+    static void helper(void* p) noexcept {
+        auto* s = static_cast<ChunkState*>(p);
+        s->work();
+        s->release();
+    }
+};
+
+template <class Pool>
+bool post_helper(Pool& pool, ChunkState* s, unsigned lane) {
+    if constexpr (has_enqueue_raw<Pool>::value) {
+        return pool.enqueue_raw(&ChunkState::helper, s, nullptr, lane);
+    } else {
+        (void)lane;
+        pool.submit([s] { ChunkState::helper(s); });
+        return true;
+    }
+}
+
+// Run chunk(b, e) over [0, n) on the caller plus up to max_helpers workers.
+template <class Pool, class Chunk>
+void run_chunks(Pool& pool, size_t n, const ParallelOptions& opts, Chunk& chunk) {
+    if (n == 0) return;
+    const size_t grain = std::max<size_t>(1, opts.grain);
+    size_t helpers = std::min<size_t>({pool_workers(pool), opts.max_helpers, (n - 1) / grain});
+    if (helpers == 0) {
+        chunk(size_t(0), n);
+        return;
+    }
+
+    auto* s = new ChunkState;
+    s->end = n;
+    s->grain = grain;
+    s->parts = helpers + 1;
+    s->body = &chunk;
+    s->invoke = [](void* c, size_t b, size_t e) { (*static_cast<Chunk*>(c))(b, e); };
+    for (size_t i = 0; i < helpers; ++i) {
+        s->refs.fetch_add(1, std::memory_order_relaxed);
+        if (!post_helper(pool, s, opts.lane)) {
+            s->refs.fetch_sub(1, std::memory_order_relaxed);
+            break; // queue full: the caller just does more of the work
+        }
+    }
+
+    s->work();
+    for (unsigned spins = 0; s->done.load(std::memory_order_acquire) < n; ++spins) {
+        if (spins < 4096) cpu_relax();
+        else std::this_thread::yield();
+    }
+    std::exception_ptr err = s->failed.load(std::memory_order_acquire) ? s->error : nullptr;
+    s->release();
+    if (err) std::rethrow_exception(err);
+}
+
+} // namespace parallel_detail
+
+// f(i) for every i in [begin, end).
+template <class Pool, class Index, class F>
+void parallel_for(Pool& pool, Index begin, Index end, F&& f, const ParallelOptions& opts = {}) {
+    if (!(begin < end)) return;
+    auto chunk = [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) f(static_cast<Index>(begin + static_cast<Index>(i)));
+    };
+    parallel_detail::run_chunks(pool, static_cast<size_t>(end - begin), opts, chunk);
+}
+
+// f(first, last) on sub-ranges of [begin, end); lets the body vectorise.
+template <class Pool, class Index, class F>
+void parallel_for_range(Pool& pool, Index begin, Index end, F&& f, const ParallelOptions& opts = {}) {
+    if (!(begin < end)) return;
+    auto chunk = [&](size_t b, size_t e) {
+        f(static_cast<Index>(begin + static_cast<Index>(b)), static_cast<Index>(begin + static_cast<Index>(e)));
+    };
+    parallel_detail::run_chunks(pool, static_cast<size_t>(end - begin), opts, chunk);
+}
+
+// Reduce [first, last) with an associative, commutative op. Each chunk is
+// folded serially from 'identity' and the partials are combined as chunks
+// finish, so floating-point results may differ run to run.
+template <class Pool, class It, class T, class Op = std::plus<>>
+T parallel_reduce(Pool& pool, It first, It last, T identity, Op op = {},
+                  const ParallelOptions& opts = {}) {
+    T result = identity;
+    SpinLock lock;
+    auto chunk = [&](size_t b, size_t e) {
+        T acc = identity;
+        for (It it = first + b, stop = first + e; it != stop; ++it) acc = op(std::move(acc), *it);
+        std::lock_guard<SpinLock> g(lock);
+        result = op(std::move(result), std::move(acc));
+    };
+    parallel_detail::run_chunks(pool, static_cast<size_t>(std::distance(first, last)), opts, chunk);
+    return result;
+}
+
+// out[i] = f(first[i]); returns the end of the output range.
+template <class Pool, class It, class Out, class F>
+Out parallel_transform(Pool& pool, It first, It last, Out out, F&& f, const ParallelOptions& opts = {}) {
+    size_t n = static_cast<size_t>(std::distance(first, last));
+    auto chunk = [&](size_t b, size_t e) {
+        std::transform(first + b, first + e, out + b, f);
+    };
+    parallel_detail::run_chunks(pool, n, opts, chunk);
+    return out + n;
+}
+
+// Inclusive scan (out may alias first). Two passes over up to 4 blocks per
+// participant: block totals in parallel, a short serial scan of the totals,
+// then each block rescanned in parallel from its offset.
+template <class Pool, class It, class Out, class Op = std::plus<>>
+Out parallel_scan(Pool& pool, It first, It last, Out out, Op op = {}, const ParallelOptions& opts = {}) {
+    using T = typename std::iterator_traits<It>::value_type;
+    size_t n = static_cast<size_t>(std::distance(first, last));
+    size_t grain = std::max<size_t>(1, opts.grain);
+    size_t parts = std::min<size_t>(parallel_detail::pool_workers(pool), opts.max_helpers) + 1;
+    size_t blocks = std::min(parts * 4, (n + grain - 1) / grain);
+    if (blocks <= 1) return std::inclusive_scan(first, last, out, op);
+
+    size_t per = (n + blocks - 1) / blocks;
+    blocks = (n + per - 1) / per; // no empty trailing block
+    std::vector<T> totals(blocks);
+    ParallelOptions block_opts = opts;
+    block_opts.grain = 1;
+
+    auto reduce_block = [&](size_t bb, size_t be) {
+        for (size_t k = bb; k < be; ++k) {
+            size_t b = k * per, e = std::min(n, b + per);
+            T acc = first[b];
+            for (size_t i = b + 1; i < e; ++i) acc = op(std::move(acc), first[i]);
+            totals[k] = std::move(acc);
+        }
+    };
+    parallel_detail::run_chunks(pool, blocks, block_opts, reduce_block);
+
+    for (size_t k = 1; k < blocks; ++k) totals[k] = op(totals[k - 1], totals[k]);
+
+    auto scan_block = [&](size_t bb, size_t be) {
+        for (size_t k = bb; k < be; ++k) {
+            size_t b = k * per, e = std::min(n, b + per);
+            if (k == 0) {
+                std::inclusive_scan(first + b, first + e, out + b, op);
+            } else {
+                std::inclusive_scan(first + b, first + e, out + b, op, totals[k - 1]);
+            }
+        }
+    };
+    parallel_detail::run_chunks(pool, blocks, block_opts, scan_block);
+    return out + n;
+}
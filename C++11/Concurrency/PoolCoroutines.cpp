@@ -0,0 +1,46 @@
+// g++ -std=c++20 -O2 -pthread PoolCoroutines.cpp
+#include <iostream>
+
+#include "PoolCoroutines.hpp"
+
+// Coroutine version of lambdaCaptureWithCallback / doSomethingAsync from
+// C++14/cpp14Features.cpp: no nested callbacks, no blocked threads.
+task<int> fetch_price(LowLatencyThreadPool& pool, int id) {
+    co_await pool.schedule();           // now on a worker
+    co_return 100 + id;
+}
+
+task<int> fetch_qty(LowLatencyThreadPool& pool) {
+    co_await pool.schedule();
+    co_return 7;
+}
+
+task<void> log_line(LowLatencyThreadPool& pool, const char* msg) {
+    co_await pool.schedule();
+    std::cout << msg << "\n";
+}
+
+task<int> notional(LowLatencyThreadPool& pool) {
+    // Both legs run concurrently on workers; resumes when both are done.
+    auto [price, qty, done] = co_await when_all(fetch_price(pool, 1), fetch_qty(pool),
+                                                log_line(pool, "legs requested"));
+    (void)done;
+    co_return price * qty;
+}
+
+task<long> hop_chain(LowLatencyThreadPool& pool, int hops) {
+    long sum = 0;
+    for (int i = 0; i < hops; ++i) {
+        co_await pool.schedule();       // symmetric transfer: no stack growth
+        sum += i;
+    }
+    co_return sum;
+}
+
+int main() {
+    LowLatencyThreadPool pool(4);
+    int n = sync_wait(notional(pool));
+    std::cout << "notional=" << n << "\n";
+    long sum = sync_wait(hop_chain(pool, 100000));
+    std::cout << "hop sum=" << sum << "\n";
+}
@@ -0,0 +1,353 @@
+#pragma once
+
+// C++20: build with -std=c++20.
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "LowLatencyThreadPool.hpp"
+
+// ------------------ Coroutines on LowLatencyThreadPool ------------------
+// task<T>            lazy coroutine; starts when awaited. Completion resumes
+//                    the awaiter by symmetric transfer, so long await chains
+//                    don't grow the stack.
+// pool.schedule()    hop onto a pool worker (LowLatencyThreadPool member);
+//                    false if the lane was full and it stayed inline.
+// when_all(t...)     run tasks concurrently, resume when all are done.
+// sync_wait(t)       block a non-pool thread until a task completes.
+//
+// Coroutine frames come from FramePool: per-thread free lists in 64-byte
+// size classes, so a steady-state task doesn't reach malloc.
+
+namespace coro_detail {
+
+class FramePool {
+public:
+    static constexpr size_t kClassBytes = 64;
+    static constexpr size_t kClasses = 16;        // frames up to 1 KiB are pooled
+    static constexpr size_t kMaxCached = 256;     // per class, per thread
+
+    static void* allocate(size_t n) {
+        size_t c = size_class(n);
+        if (c < kClasses) {
+            Lists& l = lists();
+            if (FreeBlock* b = l.head[c]) {
+                l.head[c] = b->next;
+                --l.count[c];
+                return b;
+            }
+            return ::operator new((c + 1) * kClassBytes);
+        }
+        return ::operator new(n);
+    }
+
+    // Frames may be freed on another worker than the one that allocated
+    // them; they simply join that thread's cache.
+    static void deallocate(void* p, size_t n) noexcept {
+        size_t c = size_class(n);
+        if (c < kClasses) {
+            Lists& l = lists();
+            if (l.count[c] < kMaxCached) {
+                auto* b = static_cast<FreeBlock*>(p);
+                b->next = l.head[c];
+                l.head[c] = b;
+                ++l.count[c];
+                return;
+            }
+        }
+        ::operator delete(p);
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct Lists {
+        FreeBlock* head[kClasses] = {};
+        size_t count[kClasses] = {};
+        ~Lists() {
+            for (FreeBlock* h : head) {
+                while (h) {
+                    FreeBlock* n = h->next;
+                    ::operator delete(h);
+                    h = n;
+                }
+            }
+        }
+    };
+
+    static size_t size_class(size_t n) noexcept { return (n - 1) / kClassBytes; }
+
+    static Lists& lists() {
+        thread_local Lists l;
+        return l;
+    }
+};
+
+struct PooledFrame {
+    static void* operator new(size_t n) { return FramePool::allocate(n); }
+    static void operator delete(void* p, size_t n) noexcept { FramePool::deallocate(p, n); }
+};
+
+// void results are stored as std::monostate so when_all can tuple them.
+template <class T>
+using stored_t = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+template <class T>
+struct Result {
+    std::variant<std::monostate, stored_t<T>, std::exception_ptr> v;
+
+    template <class U>
+    void set(U&& u) { v.template emplace<1>(std::forward<U>(u)); }
+    void set_error(std::exception_ptr e) noexcept { v.template emplace<2>(std::move(e)); }
+
+    stored_t<T> take() {
+        if (v.index() == 2) std::rethrow_exception(std::get<2>(v));
+        return std::move(std::get<1>(v));
+    }
+};
+
+// Waiter for sync_wait: futex-backed one-shot event. The waiter owns it
+// (it lives on sync_wait's stack), so wait() must not return while set()
+// is still touching the word: set() goes 0/kWaiting -> kSetting -> kDone,
+// and only kDone lets the waiter go. kSetting lasts a wake syscall at most.
+struct Event {
+    static constexpr uint32_t kWaiting = 1, kSetting = 2, kDone = 3;
+
+    std::atomic<uint32_t> word{0};
+    void set() noexcept {
+        if (word.exchange(kSetting, std::memory_order_acq_rel) == kWaiting) futex_wake(word, 1);
+        word.store(kDone, std::memory_order_release);
+    }
+    void wait() noexcept {
+        for (;;) {
+            uint32_t w = word.load(std::memory_order_acquire);
+            if (w == kDone) return;
+            if (w == kSetting) {
+                cpu_relax();
+                continue;
+            }
+            if (w == 0 && !word.compare_exchange_weak(w, kWaiting, std::memory_order_acq_rel)) continue;
+            futex_wait(word, kWaiting);
+        }
+    }
+};
+
+} // namespace coro_detail
+
+template <class T = void>
+class task;
+
+namespace coro_detail {
+
+struct PromiseBase : PooledFrame {
+    std::coroutine_handle<> continuation;
+
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        template <class P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+            std::coroutine_handle<> c = h.promise().continuation;
+            return c ? c : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+};
+
+template <class T>
+struct Promise : PromiseBase {
+    Result<T> result;
+    task<T> get_return_object() noexcept;
+    template <class U>
+    void return_value(U&& u) { result.set(std::forward<U>(u)); }
+    void unhandled_exception() noexcept { result.set_error(std::current_exception()); }
+};
+
+template <>
+struct Promise<void> : PromiseBase {
+    Result<void> result;
+    task<void> get_return_object() noexcept;
+    void return_void() noexcept { result.set(std::monostate{}); }
+    void unhandled_exception() noexcept { result.set_error(std::current_exception()); }
+};
+
+} // namespace coro_detail
+
+template <class T>
+class [[nodiscard]] task {
+public:
+    using promise_type = coro_detail::Promise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    task() noexcept = default;
+    explicit task(handle_type h) noexcept : h_(h) {}
+    task(task&& o) noexcept : h_(std::exchange(o.h_, {})) {}
+    task& operator=(task&& o) noexcept {
+        if (this != &o) {
+            if (h_) h_.destroy();
+            h_ = std::exchange(o.h_, {});
+        }
+        return *this;
+    }
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+    ~task() {
+        if (h_) h_.destroy();
+    }
+
+    bool done() const noexcept { return !h_ || h_.done(); }
+
+    // Awaiting starts the task and transfers straight into it.
+    auto operator co_await() & noexcept { return Awaiter{h_}; }
+    auto operator co_await() && noexcept { return Awaiter{h_}; }
+
+    // Used by when_all/sync_wait to collect the result after completion.
+    coro_detail::stored_t<T> take_result() { return h_.promise().result.take(); }
+
+private:
+    struct Awaiter {
+        handle_type h;
+        bool await_ready() const noexcept { return !h || h.done(); }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+            h.promise().continuation = awaiting;
+            return h;
+        }
+        T await_resume() {
+            if constexpr (std::is_void_v<T>) h.promise().result.take();
+            else return h.promise().result.take();
+        }
+    };
+
+    handle_type h_{};
+};
+
+namespace coro_detail {
+
+template <class T>
+task<T> Promise<T>::get_return_object() noexcept {
+    return task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline task<void> Promise<void>::get_return_object() noexcept {
+    return task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+// ------------------------------ when_all ---------------------------------
+// Each child task is driven by a small starter coroutine. Whoever drops
+// 'remaining' to zero transfers to the awaiting coroutine; the awaiter
+// holds one extra count so children finishing synchronously during start
+// can't resume it before it has suspended.
+struct WhenAllState {
+    std::atomic<size_t> remaining;
+    std::coroutine_handle<> continuation;
+};
+
+struct Starter {
+    struct promise_type : PooledFrame {
+        WhenAllState* state = nullptr;
+
+        Starter get_return_object() noexcept {
+            return Starter{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                WhenAllState* s = h.promise().state;
+                if (s->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) return s->continuation;
+                return std::noop_coroutine();
+            }
+            void await_resume() const noexcept {}
+        };
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); } // children catch via task result
+    };
+
+    std::coroutine_handle<promise_type> h;
+    Starter(Starter&& o) noexcept : h(std::exchange(o.h, {})) {}
+    explicit Starter(std::coroutine_handle<promise_type> hh) noexcept : h(hh) {}
+    ~Starter() {
+        if (h) h.destroy();
+    }
+};
+
+// Completes the child without unwrapping: its result stays in its promise.
+template <class T>
+Starter start_child(task<T>& t) {
+    try {
+        co_await t;
+    } catch (...) {
+        // kept in t's promise; rethrown by take_result()
+    }
+}
+
+template <class>
+using starter_for = Starter;
+
+template <class... Starters>
+void launch(WhenAllState& s, Starters&... st) {
+    ((st.h.promise().state = &s), ...);
+    (st.h.resume(), ...);
+}
+
+} // namespace coro_detail
+
+// Start all tasks (each typically co_awaits pool.schedule() first so they
+// spread over workers) and resume with a tuple of results; void results
+// appear as std::monostate. The first failure is rethrown.
+template <class... Ts>
+task<std::tuple<coro_detail::stored_t<Ts>...>> when_all(task<Ts>... tasks) {
+    coro_detail::WhenAllState state{sizeof...(Ts) + 1, {}};
+    std::tuple<coro_detail::starter_for<Ts>...> starters{coro_detail::start_child(tasks)...};
+
+    struct Awaiter {
+        coro_detail::WhenAllState& s;
+        std::tuple<coro_detail::starter_for<Ts>...>& st;
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> h) noexcept {
+            s.continuation = h;
+            std::apply([&](auto&... x) { coro_detail::launch(s, x...); }, st);
+            return s.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+        }
+        void await_resume() const noexcept {}
+    };
+    co_await Awaiter{state, starters};
+    co_return std::tuple<coro_detail::stored_t<Ts>...>(tasks.take_result()...);
+}
+
+// Block the calling (non-worker) thread until t completes.
+template <class T>
+T sync_wait(task<T> t) {
+    coro_detail::Event ev;
+    struct Driver {
+        struct promise_type : coro_detail::PooledFrame {
+            Driver get_return_object() noexcept { return {}; }
+            std::suspend_never initial_suspend() const noexcept { return {}; }
+            std::suspend_never final_suspend() const noexcept { return {}; }
+            void return_void() noexcept {}
+            void unhandled_exception() noexcept {}
+        };
+    };
+    auto drive = [](task<T>& tk, coro_detail::Event& e) -> Driver {
+        try {
+            co_await tk;
+        } catch (...) {
+        }
+        e.set();
+    };
+    drive(t, ev);
+    ev.wait();
+    if constexpr (std::is_void_v<T>) t.take_result();
+    else return t.take_result();
+}
@@ -0,0 +1,43 @@
+// g++ -std=c++17 -O2 -pthread -DULLTP_ENABLE_TRACE=1 PoolTrace.cpp -o trace.out
+// ./trace.out && open trace.json in ui.perfetto.dev
+#include <iostream>
+
+#include "LowLatencyThreadPool.hpp"
+
+static void quote(void*) noexcept {
+    volatile double px = 0;
+    for (int i = 0; i < 2000; ++i) px = px + i * 0.5;
+}
+
+static void risk_check(void*) noexcept {
+    volatile double px = 0;
+    for (int i = 0; i < 20000; ++i) px = px + i * 0.25;
+}
+
+int main() {
+    PoolOptions opts;
+    opts.name_prefix = "trace";
+    LowLatencyThreadPool pool(2, opts);
+
+    ULLTP_TRACE_NAMED(Mark, "burst begin");
+    for (int i = 0; i < 1000; ++i) {
+        while (!pool.enqueue_raw(i % 10 ? quote : risk_check, nullptr)) cpu_relax();
+    }
+    ULLTP_TRACE_NAMED(Mark, "burst end");
+
+    // Short-lived submitters one after another share a single ring.
+    for (int t = 0; t < 8; ++t) {
+        std::thread([&pool] {
+            for (int i = 0; i < 100; ++i) {
+                while (!pool.enqueue_raw(quote, nullptr)) cpu_relax();
+            }
+        }).join();
+    }
+    pool.shutdown();
+
+    if (!ULLTP_ENABLE_TRACE) std::cout << "built without -DULLTP_ENABLE_TRACE=1: trace will be empty\n";
+    std::cout << "quote=" << reinterpret_cast<void*>(quote)
+              << " risk_check=" << reinterpret_cast<void*>(risk_check) << "\n";
+    std::cout << "rings=" << pool_trace::Registry::instance().rings() << "\n";
+    if (pool_trace::write_chrome_trace("trace.json")) std::cout << "wrote trace.json\n";
+}
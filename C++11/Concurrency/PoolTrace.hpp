@@ -0,0 +1,297 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// ----------------------- Task execution tracing -----------------------
+// Build with -DULLTP_ENABLE_TRACE=1 to have the pools record enqueue,
+// dequeue, start and end events; with 0 (the default) the ULLTP_TRACE*
+// hooks expand to nothing.
+//
+// Each thread writes 16-byte events (TSC + kind, tag) into its own ring
+// that is allocated once and then overwritten oldest-first, so recording
+// is a timestamp read and two stores. write_chrome_trace() converts the
+// rings to Chrome trace JSON (chrome://tracing, ui.perfetto.dev); tags are
+// job function pointers or, for named events, string literals.
+//
+// When a thread exits its ring is kept, events and all, and handed to the
+// next thread that starts recording, so trace memory follows the number of
+// threads alive at once rather than every thread ever created (resizes,
+// autoscaling, short-lived submitters). The new owner's events follow the
+// old ones and the export attributes each to the thread that wrote it.
+//
+// Exporting while threads record is allowed; events being overwritten at
+// that moment may come out garbled, so export after the interesting part.
+
+#ifndef ULLTP_ENABLE_TRACE
+#define ULLTP_ENABLE_TRACE 0
+#endif
+
+#ifndef ULLTP_TRACE_RING
+#define ULLTP_TRACE_RING (1u << 16)   // events per thread, power of two
+#endif
+
+namespace pool_trace {
+
+enum class Kind : uint8_t { Enqueue, Dequeue, Start, End, Mark };
+
+// Tag is a string literal rather than a code address.
+constexpr uint8_t kNamed = 0x80;
+
+struct Event {
+    uint64_t ts_kind;   // ticks << 8 | kind
+    const void* tag;
+};
+
+inline uint64_t ticks() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+inline uint64_t steady_ns() noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// A thread that wrote to a ring, from event number 'from' on.
+struct Owner {
+    uint64_t from = 0;
+    long tid = 0;
+    char name[16] = {};
+};
+
+struct alignas(64) ThreadRing {
+    std::atomic<uint64_t> head{0};
+    std::unique_ptr<Event[]> events{new Event[ULLTP_TRACE_RING]};
+    std::atomic<bool> in_use{true};
+    std::vector<Owner> owners;   // oldest first; guarded by the registry mutex
+};
+
+class Registry {
+public:
+    static Registry& instance() {
+        static Registry r;
+        return r;
+    }
+
+    // A ring for the calling thread: one an exited thread released, else a
+    // new one.
+    ThreadRing* add() {
+        Owner me;
+#if defined(__linux__)
+        me.tid = static_cast<long>(syscall(SYS_gettid));
+        pthread_getname_np(pthread_self(), me.name, sizeof(me.name));
+#else
+        me.tid = static_cast<long>(std::hash<std::thread::id>()(std::this_thread::get_id()) & 0x7fffffff);
+#endif
+        std::lock_guard<std::mutex> g(mutex_);
+        for (auto& r : rings_) {
+            if (r->in_use.load(std::memory_order_acquire)) continue;
+            me.from = r->head.load(std::memory_order_relaxed);
+            // Forget owners whose events have all been overwritten.
+            size_t keep = 0;
+            while (keep + 1 < r->owners.size() &&
+                   r->owners[keep + 1].from + ULLTP_TRACE_RING <= me.from)
+                ++keep;
+            r->owners.erase(r->owners.begin(), r->owners.begin() + keep);
+            r->owners.push_back(me);
+            r->in_use.store(true, std::memory_order_relaxed);
+            return r.get();
+        }
+        auto ring = std::make_unique<ThreadRing>();
+        ring->owners.push_back(me);
+        rings_.push_back(std::move(ring));
+        return rings_.back().get();
+    }
+
+    // The ring's thread is exiting; its events stay until overwritten.
+    void release(ThreadRing* r) noexcept { r->in_use.store(false, std::memory_order_release); }
+
+    void set_name(ThreadRing* r, const char* name) {
+        std::lock_guard<std::mutex> g(mutex_);
+        std::snprintf(r->owners.back().name, sizeof(r->owners.back().name), "%s", name);
+    }
+
+    // Rings live as long as the process so exited threads still export.
+    template <class F>
+    void for_each(F&& f) {
+        std::lock_guard<std::mutex> g(mutex_);
+        for (auto& r : rings_) f(*r);
+    }
+
+    size_t rings() {
+        std::lock_guard<std::mutex> g(mutex_);
+        return rings_.size();
+    }
+
+    uint64_t base_ticks() const noexcept { return base_ticks_; }
+    uint64_t base_ns() const noexcept { return base_ns_; }
+
+private:
+    Registry() : base_ticks_(ticks()), base_ns_(steady_ns()) {}
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadRing>> rings_;
+    const uint64_t base_ticks_;
+    const uint64_t base_ns_;
+};
+
+// The calling thread's ring, taken on first use and released at exit. Pool workers call this
+// when they start, with their name (set on the native handle by the
+// creating thread, so not reliably visible yet), to keep the allocation
+// off the job path.
+inline ThreadRing* register_thread(const char* name = nullptr) {
+    struct Slot {
+        ThreadRing* ring = Registry::instance().add();
+        ~Slot() { Registry::instance().release(ring); }
+    };
+    thread_local Slot slot;
+    if (name) Registry::instance().set_name(slot.ring, name);
+    return slot.ring;
+}
+
+inline void record(Kind k, const void* tag, uint8_t flags = 0) noexcept {
+    ThreadRing* r = register_thread();
+    uint64_t h = r->head.load(std::memory_order_relaxed);
+    Event& e = r->events[h & (ULLTP_TRACE_RING - 1)];
+    e.ts_kind = (ticks() << 8) | static_cast<uint8_t>(k) | flags;
+    e.tag = tag;
+    r->head.store(h + 1, std::memory_order_release);
+}
+
+// Streams a C string as the body of a JSON string literal: quotes,
+// backslashes and control characters escaped, other bytes (UTF-8) as is.
+struct JsonString {
+    const char* s;
+};
+
+inline std::ostream& operator<<(std::ostream& out, JsonString j) {
+    for (const char* p = j.s; *p; ++p) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        switch (c) {
+        case '"':  out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\r': out << "\\r"; break;
+        case '\t': out << "\\t"; break;
+        default:
+            if (c < 0x20) {
+                char esc[8];
+                std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+                out << esc;
+            } else {
+                out << static_cast<char>(c);
+            }
+        }
+    }
+    return out;
+}
+
+// Chrome trace JSON of everything still in the rings. Job slices are B/E
+// pairs; enqueue, dequeue and marks are thread-scoped instants.
+inline void write_chrome_trace(std::ostream& out) {
+    Registry& reg = Registry::instance();
+    // Calibrate ticks against steady_clock over the registry's lifetime.
+    uint64_t t1 = ticks(), n1 = steady_ns();
+    if (n1 - reg.base_ns() < 10000000) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        t1 = ticks();
+        n1 = steady_ns();
+    }
+    const double ns_per_tick = t1 > reg.base_ticks()
+        ? double(n1 - reg.base_ns()) / double(t1 - reg.base_ticks()) : 1.0;
+    const uint64_t base = reg.base_ticks() & (~uint64_t(0) >> 8);
+
+    static const char* const kinds[] = {"enqueue", "dequeue", "start", "end", "mark"};
+    char buf[64];
+    bool first = true;
+    auto sep = [&] {
+        if (!first) out << ",\n";
+        first = false;
+    };
+    auto label = [&](const Event& e) -> const char* {
+        if (e.ts_kind & kNamed) return static_cast<const char*>(e.tag);
+        std::snprintf(buf, sizeof(buf), "job %p", e.tag);
+        return buf;
+    };
+
+    out << "{\"traceEvents\":[\n";
+    reg.for_each([&](ThreadRing& r) {
+        for (const Owner& o : r.owners) {
+            sep();
+            out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << o.tid
+                << ",\"args\":{\"name\":\"" << JsonString{o.name[0] ? o.name : "thread"} << "\"}}";
+        }
+        uint64_t head = r.head.load(std::memory_order_acquire);
+        uint64_t begin = head > ULLTP_TRACE_RING ? head - ULLTP_TRACE_RING : 0;
+        size_t owner = 0;
+        unsigned open = 0;
+        for (uint64_t i = begin; i < head; ++i) {
+            while (owner + 1 < r.owners.size() && r.owners[owner + 1].from <= i) {
+                ++owner;
+                open = 0;
+            }
+            const long tid = r.owners[owner].tid;
+            const Event& e = r.events[i & (ULLTP_TRACE_RING - 1)];
+            unsigned kind = e.ts_kind & 0x7f;
+            if (kind > static_cast<unsigned>(Kind::Mark)) continue;
+            uint64_t t = e.ts_kind >> 8;
+            double us = (double(int64_t(t - base)) * ns_per_tick) / 1000.0;
+            const char* ph = "i";
+            if (kind == static_cast<unsigned>(Kind::Start)) {
+                ph = "B";
+                ++open;
+            } else if (kind == static_cast<unsigned>(Kind::End)) {
+                if (open == 0) continue; // its start was overwritten
+                ph = "E";
+                --open;
+            }
+            sep();
+            out << "{\"ph\":\"" << ph << "\",\"pid\":1,\"tid\":" << tid << ",\"ts\":" << std::fixed << us;
+            if (*ph == 'i') out << ",\"s\":\"t\",\"name\":\"" << kinds[kind] << ' ' << JsonString{label(e)} << "\"}";
+            else out << ",\"name\":\"" << JsonString{label(e)} << "\"}";
+        }
+    });
+    out << "\n]}\n";
+}
+
+inline bool write_chrome_trace(const char* path) {
+    std::ofstream f(path);
+    if (!f) return false;
+    write_chrome_trace(f);
+    return static_cast<bool>(f);
+}
+
+} // namespace pool_trace
+
+#if ULLTP_ENABLE_TRACE
+#define ULLTP_TRACE(kind, tag) ::pool_trace::record(::pool_trace::Kind::kind, reinterpret_cast<const void*>(tag))
+#define ULLTP_TRACE_NAMED(kind, name) ::pool_trace::record(::pool_trace::Kind::kind, name, ::pool_trace::kNamed)
+#define ULLTP_TRACE_THREAD(name) ((void)::pool_trace::register_thread(name))
+#else
+#define ULLTP_TRACE(kind, tag) ((void)0)
+#define ULLTP_TRACE_NAMED(kind, name) ((void)0)
+#define ULLTP_TRACE_THREAD(name) ((void)0)
+#endif
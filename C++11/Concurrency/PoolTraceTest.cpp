@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "PoolTrace.hpp"
+
+namespace {
+
+// Every string literal is terminated and free of raw control characters,
+// which is what makes chrome://tracing and Perfetto reject a file.
+bool strings_well_formed(const std::string& json) {
+    bool in_string = false;
+    for (size_t i = 0; i < json.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(json[i]);
+        if (!in_string) {
+            if (c == '"') in_string = true;
+        } else if (c == '\\') {
+            ++i;
+        } else if (c == '"') {
+            in_string = false;
+        } else if (c < 0x20) {
+            return false;
+        }
+    }
+    return !in_string;
+}
+
+} // namespace
+
+TEST(PoolTraceTest, EscapesNamedTags) {
+    pool_trace::record(pool_trace::Kind::Mark, "say \"hi\" \\ now\n", pool_trace::kNamed);
+    std::ostringstream out;
+    pool_trace::write_chrome_trace(out);
+    const std::string json = out.str();
+    EXPECT_NE(json.find("mark say \\\"hi\\\" \\\\ now\\n"), std::string::npos);
+    EXPECT_TRUE(strings_well_formed(json));
+}
+
+TEST(PoolTraceTest, EscapesThreadNames) {
+    std::thread([] {
+        pool_trace::register_thread("q\"\t1");
+        pool_trace::record(pool_trace::Kind::Start, "job", pool_trace::kNamed);
+        pool_trace::record(pool_trace::Kind::End, "job", pool_trace::kNamed);
+    }).join();
+    std::ostringstream out;
+    pool_trace::write_chrome_trace(out);
+    const std::string json = out.str();
+    EXPECT_NE(json.find("\"name\":\"q\\\"\\t1\""), std::string::npos);
+    EXPECT_TRUE(strings_well_formed(json));
+}
+
+TEST(PoolTraceTest, JsonStringControlCharacters) {
+    std::ostringstream out;
+    out << pool_trace::JsonString{"a\x01" "b\x1f"};
+    EXPECT_EQ(out.str(), "a\\u0001b\\u001f");
+}
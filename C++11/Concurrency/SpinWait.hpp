@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined(__linux__)
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Spinning and parking building blocks shared by the pool and the queues:
+// cpu_relax(), futex wait/wake on a 32-bit word, a spin lock and the
+// cache-line size used for padding.
+
+// Spin-wait hint: lets the sibling hyperthread run and avoids the memory-order
+// machine clear when the awaited line finally changes.
+inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+// Block while word == expected (spurious returns allowed) / wake waiters.
+inline void futex_wait(std::atomic<uint32_t>& word, uint32_t expected) noexcept {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected,
+            nullptr, nullptr, 0);
+#elif defined(__cpp_lib_atomic_wait)
+    word.wait(expected, std::memory_order_relaxed);
+#else
+    if (word.load(std::memory_order_relaxed) == expected)
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+#endif
+}
+
+// As above, giving up after 'timeout'.
+inline void futex_wait(std::atomic<uint32_t>& word, uint32_t expected,
+                       std::chrono::nanoseconds timeout) noexcept {
+    if (timeout <= std::chrono::nanoseconds::zero()) return;
+#if defined(__linux__)
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+    ts.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected,
+            &ts, nullptr, 0);
+#else
+    if (word.load(std::memory_order_relaxed) == expected)
+        std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(timeout, std::chrono::microseconds(50)));
+#endif
+}
+
+inline void futex_wake(std::atomic<uint32_t>& word, int count) noexcept {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, count,
+            nullptr, nullptr, 0);
+#elif defined(__cpp_lib_atomic_wait)
+    if (count == 1) word.notify_one(); else word.notify_all();
+#else
+    (void)word; (void)count;
+#endif
+}
+
+// Test-and-test-and-set lock for short critical sections; BasicLockable so
+// it works with std::lock_guard.
+class SpinLock {
+public:
+    void lock() noexcept {
+        while (flag_.exchange(true, std::memory_order_acquire)) {
+            while (flag_.load(std::memory_order_relaxed)) cpu_relax();
+        }
+    }
+    bool try_lock() noexcept {
+        return !flag_.load(std::memory_order_relaxed) &&
+               !flag_.exchange(true, std::memory_order_acquire);
+    }
+    void unlock() noexcept { flag_.store(false, std::memory_order_release); }
+
+private:
+    std::atomic<bool> flag_{false};
+};
+
+#ifndef ULLTP_CACHELINE
+#define ULLTP_CACHELINE 64
+#endif
+
+struct alignas(ULLTP_CACHELINE) CachelinePad { char pad[ULLTP_CACHELINE]; };
@@ -0,0 +1,35 @@
+#include <iostream>
+#include <vector>
+
+#include "Strand.hpp"
+
+// Per-instrument ordering: every instrument's updates must apply in
+// sequence, instruments are processed in parallel and no handler locks.
+int main() {
+    LowLatencyThreadPool pool(4);
+    const size_t instruments = 200000, updates = 5;
+    std::vector<uint32_t> last_seq(instruments, 0);
+    std::atomic<size_t> out_of_order{0};
+
+    {
+        KeyedExecutor exec(pool, 4096);
+        for (uint32_t seq = 1; seq <= updates; ++seq) {
+            for (size_t id = 0; id < instruments; ++id) {
+                exec.post(id, [&, id, seq] {
+                    if (last_seq[id] + 1 != seq) out_of_order.fetch_add(1, std::memory_order_relaxed);
+                    last_seq[id] = seq;
+                });
+            }
+        }
+        exec.wait_idle();
+    }
+    std::cout << instruments * updates << " updates over " << instruments
+              << " instruments, out of order: " << out_of_order.load() << "\n";
+
+    // A single strand serialises plain shared state.
+    Strand strand(pool);
+    long counter = 0;
+    for (int i = 0; i < 100000; ++i) strand.post([&] { ++counter; });
+    strand.post([&] { std::cout << "counter=" << counter << " on strand: " << strand.running_in_this_thread() << "\n"; });
+    strand.wait_idle();
+}
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "LowLatencyThreadPool.hpp"
+
+// ------------------- Strands / keyed ordered execution -------------------
+// A Strand runs the handlers posted to it one at a time, in FIFO order, on
+// whichever pool worker picks it up; different strands run in parallel.
+// Nothing on the execution path takes a lock:
+//   - post() pushes onto an intrusive Vyukov MPSC list (one exchange) and
+//     bumps 'pending'; the poster that takes 'pending' from 0 to 1 enqueues
+//     a drain job into the pool.
+//   - the drain job runs up to 'batch' handlers and then subtracts them. If
+//     more arrived meanwhile it re-enqueues itself rather than hogging the
+//     worker, so a hot strand can't starve the others. If the lane is full
+//     it keeps draining instead: the worker may be the one that would
+//     empty it.
+//   - a poster that finds the lane full backs off briefly, then runs the
+//     drain itself (it could be a pool job on the only worker).
+// At most one drain job per strand exists at a time, which is what gives
+// the ordering.
+//
+// KeyedExecutor hashes keys (instrument ids, sessions...) onto a fixed set
+// of strands, so any number of keys costs the same memory. Equal keys
+// always share a strand; distinct keys may too (false sharing of order,
+// never of data), so size the set well above the worker count.
+//
+// Handlers must not throw (they run on a noexcept pool path).
+
+class Strand {
+public:
+    explicit Strand(LowLatencyThreadPool& pool, unsigned lane = 0, unsigned batch = 64)
+    : pool_(pool), lane_(lane), batch_(batch ? batch : 1), head_(&stub_), tail_(&stub_) {}
+
+    Strand(const Strand&) = delete;
+    Strand& operator=(const Strand&) = delete;
+
+    // Waits for queued handlers; the pool must still be running.
+    ~Strand() { wait_idle(); }
+
+    template <class F>
+    void post(F&& f) {
+        using T = Task<std::decay_t<F>>;
+        push(new T(std::forward<F>(f)));
+        if (pending_.fetch_add(1, std::memory_order_acq_rel) == 0) schedule();
+    }
+
+    // True while the calling thread is executing one of this strand's handlers.
+    bool running_in_this_thread() const noexcept { return current() == this; }
+
+    size_t pending() const noexcept { return pending_.load(std::memory_order_relaxed); }
+
+    // Drain jobs that hit a full lane and had to retry.
+    uint64_t schedule_retries() const noexcept { return retries_.load(std::memory_order_relaxed); }
+
+    // Batches drained in place because the lane was full: by a poster that
+    // gave up backing off, or by a drain job that couldn't re-enqueue.
+    uint64_t inline_drains() const noexcept { return inline_drains_.load(std::memory_order_relaxed); }
+
+    void wait_idle() const noexcept {
+        for (unsigned i = 0; pending_.load(std::memory_order_acquire) != 0; ++i) {
+            if (i < 1024) cpu_relax();
+            else std::this_thread::yield();
+        }
+    }
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        void (*run)(Node*) noexcept = nullptr; // runs and frees the node
+    };
+
+    template <class F>
+    struct Task : Node {
+        F fn;
+        explicit Task(F&& f) : fn(std::move(f)) { this->run = &Task::invoke; }
+        explicit Task(const F& f) : fn(f) { this->run = &Task::invoke; }
+        static void invoke(Node* n) noexcept {
+            auto* t = static_cast<Task*>(n);
+            t->fn();
+            delete t;
+        }
+    };
+
+    static const Strand*& current() noexcept {
+        thread_local const Strand* s = nullptr;
+        return s;
+    }
+
+    // Producers: one exchange, then link the previous node.
+    void push(Node* n) noexcept {
+        n->next.store(nullptr, std::memory_order_relaxed);
+        Node* prev = head_.exchange(n, std::memory_order_acq_rel);
+        prev->next.store(n, std::memory_order_release);
+    }
+
+    // Consumer (the single drain job). Returns nullptr if the next node's
+    // producer has exchanged but not linked yet; the caller spins, since
+    // 'pending' already promised the node.
+    Node* pop() noexcept {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_) {
+            if (!next) return nullptr;
+            tail_ = tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next) {
+            tail_ = next;
+            return tail;
+        }
+        if (tail != head_.load(std::memory_order_acquire)) return nullptr;
+        push(&stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next) {
+            tail_ = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+    static constexpr unsigned kPostYields = 64;
+
+    // post() took 'pending' from 0: enqueue the drain job, or run it here.
+    void schedule() noexcept {
+        for (unsigned i = 0; !pool_.enqueue_raw(&Strand::drain, this, nullptr, lane_); ++i) {
+            retries_.fetch_add(1, std::memory_order_relaxed);
+            if (i == kPostYields) {
+                inline_drains_.fetch_add(1, std::memory_order_relaxed);
+                drain(this);
+                return;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    static void drain(void* p) noexcept {
+        auto* s = static_cast<Strand*>(p);
+        const Strand* outer = current();
+        current() = s;
+        for (;;) {
+            size_t avail = s->pending_.load(std::memory_order_acquire);
+            size_t n = 0;
+            while (n < avail && n < s->batch_) {
+                Node* node;
+                while (!(node = s->pop())) cpu_relax();
+                node->run(node);
+                ++n;
+            }
+            if (s->pending_.fetch_sub(n, std::memory_order_acq_rel) == n) break;
+            // Once the new job is queued another worker may run it, and
+            // finish the strand, so 's' isn't touched after that.
+            if (s->pool_.enqueue_raw(&Strand::drain, s, nullptr, s->lane_)) break;
+            s->inline_drains_.fetch_add(1, std::memory_order_relaxed);
+        }
+        current() = outer;
+    }
+
+    LowLatencyThreadPool& pool_;
+    const unsigned lane_;
+    const unsigned batch_;
+    Node stub_;
+    alignas(ULLTP_CACHELINE) std::atomic<Node*> head_;   // producers
+    alignas(ULLTP_CACHELINE) Node* tail_;                 // drain job only
+    alignas(ULLTP_CACHELINE) std::atomic<size_t> pending_{0};
+    std::atomic<uint64_t> retries_{0};
+    std::atomic<uint64_t> inline_drains_{0};
+};
+
+class KeyedExecutor {
+public:
+    // 'strands' is rounded up to a power of two.
+    explicit KeyedExecutor(LowLatencyThreadPool& pool, size_t strands = 4096, unsigned lane = 0,
+                           unsigned batch = 64) {
+        size_t n = 1;
+        while (n < strands) n <<= 1;
+        mask_ = n - 1;
+        strands_.reserve(n);
+        for (size_t i = 0; i < n; ++i) strands_.emplace_back(new Strand(pool, lane, batch));
+    }
+
+    template <class F>
+    void post(uint64_t key, F&& f) {
+        strand_for(key).post(std::forward<F>(f));
+    }
+
+    Strand& strand_for(uint64_t key) noexcept { return *strands_[mix(key) & mask_]; }
+    size_t strands() const noexcept { return strands_.size(); }
+
+    void wait_idle() const noexcept {
+        for (const auto& s : strands_) s->wait_idle();
+    }
+
+private:
+    // splitmix64 finaliser: sequential ids spread over all strands.
+    static uint64_t mix(uint64_t x) noexcept {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ull;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    std::vector<std::unique_ptr<Strand>> strands_;
+    size_t mask_ = 0;
+};
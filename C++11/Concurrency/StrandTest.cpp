@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "Strand.hpp"
+
+namespace {
+
+// Occupies the pool's only worker until released.
+struct Blocker {
+    std::atomic<bool> release{false};
+    std::atomic<bool> started{false};
+
+    void start(LowLatencyThreadPool& pool) {
+        ASSERT_TRUE(pool.enqueue_raw([](void* p) noexcept {
+            auto* b = static_cast<Blocker*>(p);
+            b->started = true;
+            while (!b->release.load()) std::this_thread::yield();
+        }, this));
+        while (!started.load()) std::this_thread::yield();
+    }
+};
+
+PoolOptions drop_oldest_options() {
+    PoolOptions opts;
+    opts.queue_capacity_pow2 = 4;
+    opts.overflow = OverflowPolicy::DropOldest;
+    opts.block_timeout = std::chrono::milliseconds(1);
+    return opts;
+}
+
+} // namespace
+
+TEST(StrandTest, RunsInOrder) {
+    LowLatencyThreadPool pool(2);
+    Strand strand(pool);
+    std::vector<int> seen;
+    for (int i = 0; i < 1000; ++i)
+        strand.post([&seen, i] { seen.push_back(i); });
+    strand.wait_idle();
+
+    ASSERT_EQ(seen.size(), 1000u);
+    for (int i = 0; i < 1000; ++i)
+        ASSERT_EQ(seen[i], i);
+}
+
+// Handlers of one strand never overlap, whichever worker runs them
+TEST(StrandTest, NoConcurrentExecution) {
+    LowLatencyThreadPool pool(4);
+    Strand strand(pool, 0, 8);
+    std::atomic<bool> in_flight{false};
+    std::atomic<int> overlaps{0}, runs{0};
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 4; ++p) {
+        producers.emplace_back([&] {
+            for (int i = 0; i < 5000; ++i) {
+                strand.post([&] {
+                    if (in_flight.exchange(true)) overlaps.fetch_add(1);
+                    EXPECT_TRUE(strand.running_in_this_thread());
+                    runs.fetch_add(1, std::memory_order_relaxed);
+                    in_flight.store(false);
+                });
+            }
+        });
+    }
+    for (auto& t : producers) t.join();
+    strand.wait_idle();
+    EXPECT_EQ(overlaps.load(), 0);
+    EXPECT_EQ(runs.load(), 4 * 5000);
+}
+
+// Many producers over many keys: each producer's updates to a key apply in
+// the order it posted them, and never two at once
+TEST(StrandTest, KeyedExecutorPerKeyOrder) {
+    constexpr int producers = 4, keys = 256, updates = 200;
+    LowLatencyThreadPool pool(4);
+    std::vector<int> last(producers * keys, 0);
+    std::vector<std::atomic<int>> busy(keys);
+    std::atomic<int> out_of_order{0}, overlaps{0};
+    {
+        KeyedExecutor exec(pool, 64, 0, 16);
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&, p] {
+                for (int seq = 1; seq <= updates; ++seq) {
+                    for (int k = 0; k < keys; ++k) {
+                        exec.post(k, [&, p, k, seq] {
+                            if (busy[k].fetch_add(1) != 0) overlaps.fetch_add(1);
+                            int& l = last[p * keys + k];
+                            if (l + 1 != seq) out_of_order.fetch_add(1);
+                            l = seq;
+                            busy[k].fetch_sub(1);
+                        });
+                    }
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+        exec.wait_idle();
+    }
+    EXPECT_EQ(out_of_order.load(), 0);
+    EXPECT_EQ(overlaps.load(), 0);
+    for (int v : last) ASSERT_EQ(v, updates);
+}
+
+// On a single worker a handler fills the lane by posting to other strands:
+// neither those posts nor the strand's own re-enqueue may spin on it
+TEST(StrandTest, FullLaneOnSingleWorker) {
+    PoolOptions opts;
+    opts.queue_capacity_pow2 = 2;
+    LowLatencyThreadPool pool(1, opts);
+    Strand strand(pool, 0, 1);
+    std::vector<std::unique_ptr<Strand>> others;
+    for (int i = 0; i < 4; ++i) others.push_back(std::make_unique<Strand>(pool));
+
+    Blocker blocker;
+    blocker.start(pool);
+    std::atomic<int> runs{0};
+    strand.post([&] {
+        for (auto& s : others) s->post([&runs] { runs.fetch_add(1); });
+    });
+    strand.post([&runs] { runs.fetch_add(1); });
+    blocker.release = true;
+
+    strand.wait_idle();
+    for (auto& s : others) s->wait_idle();
+    EXPECT_EQ(runs.load(), 5);
+    uint64_t inline_drains = strand.inline_drains();
+    for (auto& s : others) inline_drains += s->inline_drains();
+    EXPECT_GT(inline_drains, 0u);
+}
+
+// Flooding a DropOldest lane with submit() drops submitted jobs, never the
+// strand's drain job
+TEST(StrandTest, SurvivesDropOldestFlood) {
+    LowLatencyThreadPool pool(1, drop_oldest_options());
+    Strand strand(pool);
+    Blocker blocker;
+    blocker.start(pool);
+
+    std::atomic<int> handled{0};
+    std::vector<std::future<void>> futures;
+    for (int round = 0; round < 10; ++round) {
+        strand.post([&handled] { handled.fetch_add(1); });
+        for (int i = 0; i < 8; ++i)
+            futures.push_back(pool.submit([] {}));
+    }
+    EXPECT_GT(pool.lane_stats(0).dropped, 0u);
+
+    blocker.release = true;
+    strand.wait_idle();
+    EXPECT_EQ(handled.load(), 10);
+    EXPECT_EQ(strand.pending(), 0u);
+
+    // Later posts still get a drain job
+    strand.post([&handled] { handled.fetch_add(1); });
+    strand.wait_idle();
+    EXPECT_EQ(handled.load(), 11);
+}
+
+// A lane holding only control jobs has nothing to drop: submit() blocks
+// and times out instead
+TEST(StrandTest, DropOldestKeepsControlJobs) {
+    LowLatencyThreadPool pool(1, drop_oldest_options());
+    Blocker blocker;
+    blocker.start(pool);
+
+    std::atomic<int> handled{0};
+    std::vector<std::unique_ptr<Strand>> strands;
+    for (size_t i = 0; i < pool.lane_capacity(0); ++i) {
+        strands.push_back(std::make_unique<Strand>(pool));
+        strands.back()->post([&handled] { handled.fetch_add(1); });
+    }
+    EXPECT_THROW(pool.submit([] {}), std::system_error);
+    EXPECT_EQ(pool.lane_stats(0).dropped, 0u);
+    EXPECT_EQ(pool.lane_stats(0).timed_out, 1u);
+
+    blocker.release = true;
+    for (auto& s : strands)
+        s->wait_idle();
+    EXPECT_EQ(handled.load(), static_cast<int>(strands.size()));
+}
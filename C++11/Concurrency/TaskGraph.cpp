@@ -0,0 +1,38 @@
+#include <iostream>
+
+#include "TaskGraph.hpp"
+
+// Per-tick pipeline: normalize -> (signals A, B, C) -> aggregate -> risk -> send
+int main() {
+    LowLatencyThreadPool pool(4);
+    TaskGraph graph(pool);
+
+    int tick = 0;
+    double px = 0, a = 0, b = 0, c = 0, signal = 0;
+    bool ok = false;
+
+    auto normalize = graph.add([&] { px = 100.0 + tick * 0.01; }, "normalize");
+    auto sigA = graph.add([&] { a = px * 0.5; }, "signalA");
+    auto sigB = graph.add([&] { b = px * 0.3; }, "signalB");
+    auto sigC = graph.add([&] { c = px * 0.2; }, "signalC");
+    auto aggregate = graph.add([&] { signal = a + b + c; }, "aggregate");
+    auto risk = graph.add([&] { ok = signal < 1000.0; }, "risk");
+    auto send = graph.add([&] { if (ok && tick % 1000 == 0) std::cout << "send " << signal << "\n"; }, "send");
+
+    for (auto s : {sigA, sigB, sigC}) {
+        graph.precede(normalize, s);
+        graph.precede(s, aggregate);
+    }
+    graph.precede(aggregate, risk);
+    graph.precede(risk, send);
+    graph.seal();
+
+    // Re-run every tick: no allocation, no blocking futures inside.
+    for (tick = 0; tick < 3000; ++tick) graph.run_and_wait();
+
+    std::vector<TaskGraph::PathStep> path;
+    uint64_t total = graph.critical_path(path);
+    std::cout << "last tick " << graph.last_run_ns() << "ns, critical path " << total << "ns:\n";
+    for (const auto& step : path)
+        std::cout << "  " << step.name << " wait=" << step.wait_ns << "ns exec=" << step.exec_ns << "ns\n";
+}
@@ -0,0 +1,268 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+#include "LowLatencyThreadPool.hpp"
+
+// ------------------- Task graph (DAG) executor --------------------
+// Build the graph once (add/precede/seal), then run() it every tick.
+// Each node carries an atomic count of unfinished predecessors; the worker
+// that drops a successor's count to zero enqueues it straight into the pool
+// (the first ready successor runs inline on the same worker, saving a
+// handoff). If the lane is full the worker keeps the successor too, on an
+// intrusive ready list, rather than wait for room it may be the only one
+// able to make. Nobody blocks on a future, and run() touches only
+// preallocated state, so re-running never allocates.
+//
+// After a run, critical_path() walks back from the last node to finish
+// through the predecessor that released each node, i.e. the chain that
+// actually determined the tick latency.
+
+class TaskGraph {
+public:
+    using NodeId = uint32_t;
+    using Clock = std::chrono::steady_clock;
+
+    struct PathStep {
+        NodeId node;
+        const char* name;
+        uint64_t wait_ns;   // released -> started (queue handoff)
+        uint64_t exec_ns;   // started -> finished
+    };
+
+    explicit TaskGraph(LowLatencyThreadPool& pool, unsigned lane = 0)
+    : pool_(pool), lane_(lane) {}
+
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    // --- Build phase ---
+    template <class F>
+    NodeId add(F&& f, const char* name = nullptr) {
+        if (sealed_) throw std::logic_error("TaskGraph: add() after seal()");
+        nodes_.emplace_back();
+        Node& n = nodes_.back();
+        n.body = std::forward<F>(f);
+        n.name = name;
+        n.graph = this;
+        return static_cast<NodeId>(nodes_.size() - 1);
+    }
+
+    // 'before' must finish before 'after' starts.
+    void precede(NodeId before, NodeId after) {
+        if (sealed_) throw std::logic_error("TaskGraph: precede() after seal()");
+        if (before >= nodes_.size() || after >= nodes_.size() || before == after)
+            throw std::invalid_argument("TaskGraph: bad edge");
+        edges_.push_back({before, after});
+    }
+
+    // Freeze the topology: flatten successor lists, count in-degrees and
+    // reject cycles. Nodes must not move after this (workers hold pointers).
+    void seal() {
+        if (sealed_) return;
+        const size_t n = nodes_.size();
+        std::vector<uint32_t> out_deg(n, 0);
+        for (const Edge& e : edges_) {
+            ++out_deg[e.from];
+            ++nodes_[e.to].in_degree;
+        }
+        succ_.resize(edges_.size());
+        uint32_t off = 0;
+        for (size_t i = 0; i < n; ++i) {
+            nodes_[i].succ_begin = off;
+            nodes_[i].succ_end = off;
+            off += out_deg[i];
+        }
+        for (const Edge& e : edges_)
+            succ_[nodes_[e.from].succ_end++] = &nodes_[e.to];
+
+        // Kahn's algorithm: every node reachable in topological order.
+        std::vector<uint32_t> indeg(n);
+        for (size_t i = 0; i < n; ++i) {
+            indeg[i] = nodes_[i].in_degree;
+            if (indeg[i] == 0) sources_.push_back(&nodes_[i]);
+        }
+        std::vector<Node*> order(sources_);
+        for (size_t k = 0; k < order.size(); ++k)
+            for (uint32_t s = order[k]->succ_begin; s < order[k]->succ_end; ++s)
+                if (--indeg[succ_[s] - nodes_.data()] == 0) order.push_back(succ_[s]);
+        if (order.size() != n) throw std::logic_error("TaskGraph: cycle detected");
+
+        edges_.clear();
+        edges_.shrink_to_fit();
+        sealed_ = true;
+    }
+
+    // --- Run phase ---
+    // Start one execution. Returns false if the graph is empty or the
+    // previous run hasn't finished. Seals on first use.
+    bool run() {
+        if (!sealed_) seal();
+        bool idle = false;
+        if (nodes_.empty() || !running_.compare_exchange_strong(idle, true, std::memory_order_acquire))
+            return false;
+        for (Node& n : nodes_) {
+            n.pending.store(n.in_degree, std::memory_order_relaxed);
+            n.released_by = kNone;
+        }
+        remaining_.store(static_cast<uint32_t>(nodes_.size()), std::memory_order_relaxed);
+        start_ns_ = now_ns();
+        // Sources that don't fit in the lane run here.
+        Node* local = nullptr;
+        for (Node* s : sources_) {
+            s->ready_ns = start_ns_;
+            if (!dispatch(s)) {
+                s->next_ready = local;
+                local = s;
+            }
+        }
+        if (local) run_ready(local);
+        return true;
+    }
+
+    // Block until the current run has finished: spin, yield, then sleep on
+    // the completion word.
+    void wait() const noexcept {
+        for (unsigned i = 0; running_.load(std::memory_order_acquire); ++i) {
+            if (i < 1024) {
+                cpu_relax();
+            } else if (i < 1024 + 64) {
+                std::this_thread::yield();
+            } else {
+                uint32_t e = done_epoch_.load(std::memory_order_acquire);
+                if (!running_.load(std::memory_order_acquire)) break;
+                futex_wait(const_cast<std::atomic<uint32_t>&>(done_epoch_), e);
+            }
+        }
+    }
+
+    void run_and_wait() {
+        if (run()) wait();
+    }
+
+    bool done() const noexcept { return !running_.load(std::memory_order_acquire); }
+    size_t size() const noexcept { return nodes_.size(); }
+    const char* name(NodeId id) const noexcept { return nodes_[id].name; }
+
+    // Last run, start of run() to end of the last node.
+    uint64_t last_run_ns() const noexcept { return end_ns_ - start_ns_; }
+
+    // Ready nodes run by the thread that released them because the lane
+    // was full (not counting the one each worker keeps by design).
+    uint64_t ran_inline() const noexcept { return ran_inline_.load(std::memory_order_relaxed); }
+
+    // Critical path of the last run, source first. Returns its total latency.
+    uint64_t critical_path(std::vector<PathStep>& out) const {
+        out.clear();
+        if (nodes_.empty() || !done()) return 0;
+        const Node* last = &nodes_[0];
+        for (const Node& n : nodes_)
+            if (n.end_ns > last->end_ns) last = &n;
+        for (const Node* n = last; n; n = n->released_by == kNone ? nullptr : &nodes_[n->released_by]) {
+            out.push_back(PathStep{static_cast<NodeId>(n - nodes_.data()), n->name,
+                                   n->start_ns - n->ready_ns, n->end_ns - n->start_ns});
+        }
+        std::reverse(out.begin(), out.end());
+        return last->end_ns - start_ns_;
+    }
+
+private:
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    struct Edge {
+        NodeId from, to;
+    };
+
+    struct alignas(ULLTP_CACHELINE) Node {
+        std::atomic<uint32_t> pending{0};
+        uint32_t in_degree = 0;
+        uint32_t succ_begin = 0;
+        uint32_t succ_end = 0;
+        uint32_t released_by = kNone;
+        Node* next_ready = nullptr;   // ready list of the thread running it
+        uint64_t ready_ns = 0;
+        uint64_t start_ns = 0;
+        uint64_t end_ns = 0;
+        TaskGraph* graph = nullptr;
+        const char* name = nullptr;
+        std::function<void()> body;
+
+        Node() = default;
+        Node(Node&& o) noexcept
+        : in_degree(o.in_degree), graph(o.graph), name(o.name), body(std::move(o.body)) {}
+    };
+
+    static uint64_t now_ns() noexcept {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now().time_since_epoch()).count();
+    }
+
+    bool dispatch(Node* n) noexcept {
+        return pool_.enqueue_raw(&TaskGraph::exec, n, nullptr, lane_);
+    }
+
+    static void exec(void* p) noexcept {
+        Node* n = static_cast<Node*>(p);
+        n->next_ready = nullptr;
+        n->graph->run_ready(n);
+    }
+
+    // Executes the ready list. Of the successors a node releases, the first
+    // joins the list and the rest are enqueued; those the full lane refuses
+    // join the list as well.
+    void run_ready(Node* ready) noexcept {
+        while (ready) {
+            Node* n = ready;
+            ready = n->next_ready;
+            n->start_ns = now_ns();
+            n->body();
+            n->end_ns = now_ns();
+            bool kept = false;
+            for (uint32_t s = n->succ_begin; s < n->succ_end; ++s) {
+                Node* succ = succ_[s];
+                if (succ->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    succ->released_by = static_cast<uint32_t>(n - nodes_.data());
+                    succ->ready_ns = n->end_ns;
+                    if (kept && dispatch(succ)) continue;
+                    if (kept) ran_inline_.fetch_add(1, std::memory_order_relaxed);
+                    kept = true;
+                    succ->next_ready = ready;
+                    ready = succ;
+                }
+            }
+            // Nodes left on the list keep the run going; after the last
+            // finish_one() the list is empty and the graph isn't touched
+            // again (the waiter may rerun or destroy it).
+            finish_one(n->end_ns);
+        }
+    }
+
+    void finish_one(uint64_t end) noexcept {
+        if (remaining_.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        end_ns_ = end;
+        running_.store(false, std::memory_order_release);
+        done_epoch_.fetch_add(1, std::memory_order_release);
+        futex_wake(done_epoch_, INT32_MAX);
+    }
+
+    LowLatencyThreadPool& pool_;
+    const unsigned lane_;
+    std::vector<Node> nodes_;
+    std::vector<Edge> edges_;
+    std::vector<Node*> succ_;
+    std::vector<Node*> sources_;
+    bool sealed_ = false;
+
+    alignas(ULLTP_CACHELINE) std::atomic<uint32_t> remaining_{0};
+    std::atomic<bool> running_{false};
+    mutable std::atomic<uint32_t> done_epoch_{0};
+    std::atomic<uint64_t> ran_inline_{0};
+    uint64_t start_ns_ = 0;
+    uint64_t end_ns_ = 0;
+};
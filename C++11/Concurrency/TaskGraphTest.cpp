@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <vector>
+
+#include "TaskGraph.hpp"
+
+// Every node runs after all of its predecessors
+TEST(TaskGraphTest, RespectsEdges) {
+    LowLatencyThreadPool pool(2);
+    TaskGraph graph(pool);
+    std::atomic<int> clock{0};
+    std::vector<int> at(4, -1);
+    auto stamp = [&](int i) { return [&, i] { at[i] = clock.fetch_add(1); }; };
+    auto a = graph.add(stamp(0), "a");
+    auto b = graph.add(stamp(1), "b");
+    auto c = graph.add(stamp(2), "c");
+    auto d = graph.add(stamp(3), "d");
+    graph.precede(a, b);
+    graph.precede(a, c);
+    graph.precede(b, d);
+    graph.precede(c, d);
+
+    for (int run = 0; run < 100; ++run) {
+        graph.run_and_wait();
+        ASSERT_LT(at[0], at[1]);
+        ASSERT_LT(at[0], at[2]);
+        ASSERT_LT(at[1], at[3]);
+        ASSERT_LT(at[2], at[3]);
+    }
+}
+
+TEST(TaskGraphTest, RejectsCycle) {
+    LowLatencyThreadPool pool(1);
+    TaskGraph graph(pool);
+    auto a = graph.add([] {});
+    auto b = graph.add([] {});
+    graph.precede(a, b);
+    graph.precede(b, a);
+    EXPECT_THROW(graph.seal(), std::logic_error);
+}
+
+// A fan-out wider than the lane on a single worker: the successors the
+// lane can't take run on the worker that released them
+TEST(TaskGraphTest, FanOutWiderThanLane) {
+    PoolOptions opts;
+    opts.queue_capacity_pow2 = 2;
+    LowLatencyThreadPool pool(1, opts);
+    TaskGraph graph(pool);
+
+    constexpr int width = 32;
+    std::atomic<int> leaves{0};
+    std::atomic<int> joined{0};
+    auto root = graph.add([] {}, "root");
+    auto join = graph.add([&] { joined.fetch_add(1); }, "join");
+    for (int i = 0; i < width; ++i) {
+        auto leaf = graph.add([&] { leaves.fetch_add(1); });
+        graph.precede(root, leaf);
+        graph.precede(leaf, join);
+    }
+
+    for (int run = 0; run < 10; ++run) graph.run_and_wait();
+    EXPECT_EQ(leaves.load(), 10 * width);
+    EXPECT_EQ(joined.load(), 10);
+    EXPECT_GT(graph.ran_inline(), 0u);
+}
+
+// More sources than the lane holds: run() executes the rest itself
+TEST(TaskGraphTest, SourcesWiderThanLane) {
+    PoolOptions opts;
+    opts.queue_capacity_pow2 = 2;
+    LowLatencyThreadPool pool(1, opts);
+    TaskGraph graph(pool);
+    std::atomic<int> runs{0};
+    for (int i = 0; i < 16; ++i) graph.add([&] { runs.fetch_add(1); });
+
+    graph.run_and_wait();
+    EXPECT_EQ(runs.load(), 16);
+}
@@ -0,0 +1,43 @@
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "TaskGroup.hpp"
+
+// Recursive divide-and-conquer on two workers: every level waits on its
+// children, which with future.get() would soon block both workers.
+static long sum_range(LowLatencyThreadPool& pool, const std::vector<int>& v, size_t b, size_t e) {
+    if (e - b <= 4096) {
+        long s = 0;
+        for (size_t i = b; i < e; ++i) s += v[i];
+        return s;
+    }
+    size_t mid = b + (e - b) / 2;
+    long left = 0;
+    task_group g(pool);
+    g.run([&] { left = sum_range(pool, v, b, mid); });
+    long right = sum_range(pool, v, mid, e);
+    g.wait();
+    return left + right;
+}
+
+int main() {
+    LowLatencyThreadPool pool(2);
+    std::vector<int> v(1 << 22, 1);
+    std::cout << "sum=" << sum_range(pool, v, 0, v.size()) << "\n";
+
+    // A worker waiting on a nested submit(): wait() helps instead of blocking.
+    auto outer = pool.submit([&] {
+        auto inner = pool.submit([] { return 20; });
+        return pool.wait(inner) + 1;
+    });
+    std::cout << "nested=" << pool.wait(outer) << "\n";
+
+    task_group g(pool);
+    g.run([] { throw std::runtime_error("task failed"); });
+    try {
+        g.wait();
+    } catch (const std::exception& e) {
+        std::cout << "caught: " << e.what() << "\n";
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+#include "LowLatencyThreadPool.hpp"
+
+// ------------------------ Fork-join task groups ------------------------
+// task_group g(pool);
+// g.run([&] { left(); });
+// right();            // the caller works too
+// g.wait();           // runs queued pool jobs until the group is done
+//
+// wait() never blocks a thread while work is queued: it executes jobs from
+// the pool (this group's or anyone's), so nested groups on pool workers
+// recurse without oversubscription or the deadlock of a worker blocking on
+// a future its peers can't get to. If a lane is full, run() executes the
+// task inline. The first exception thrown by a task is rethrown by wait().
+
+class task_group {
+public:
+    explicit task_group(LowLatencyThreadPool& pool, unsigned lane = 0) noexcept
+    : pool_(pool), lane_(lane) {}
+
+    task_group(const task_group&) = delete;
+    task_group& operator=(const task_group&) = delete;
+
+    // Tasks still reference the group; wait for them (errors are dropped).
+    ~task_group() {
+        pool_.help_until([this] { return done(); });
+    }
+
+    template <class F>
+    void run(F&& f) {
+        using T = Task<std::decay_t<F>>;
+        auto* t = new T(std::forward<F>(f), this);
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        if (!pool_.enqueue_raw(&T::exec, t, nullptr, lane_)) T::exec(t);
+    }
+
+    void wait() {
+        pool_.help_until([this] { return done(); });
+        if (failed_.load(std::memory_order_acquire)) {
+            std::exception_ptr e = std::move(error_);
+            error_ = nullptr;
+            failed_.store(false, std::memory_order_relaxed);
+            std::rethrow_exception(e);
+        }
+    }
+
+    bool done() const noexcept { return pending_.load(std::memory_order_acquire) == 0; }
+
+private:
+    template <class F>
+    struct Task {
+        F fn;
+        task_group* group;
+        Task(F&& f, task_group* g) : fn(std::move(f)), group(g) {}
+        Task(const F& f, task_group* g) : fn(f), group(g) {}
+
+        static void exec(void* p) noexcept {
+            auto* t = static_cast<Task*>(p);
+            task_group* g = t->group;
+            try {
+                t->fn();
+            } catch (...) {
+                g->fail(std::current_exception());
+            }
+            delete t;
+            g->pending_.fetch_sub(1, std::memory_order_release);
+        }
+    };
+
+    void fail(std::exception_ptr e) noexcept {
+        std::lock_guard<SpinLock> g(error_lock_);
+        if (!failed_.load(std::memory_order_relaxed)) {
+            error_ = std::move(e);
+            failed_.store(true, std::memory_order_release);
+        }
+    }
+
+    LowLatencyThreadPool& pool_;
+    const unsigned lane_;
+    alignas(ULLTP_CACHELINE) std::atomic<size_t> pending_{0};
+    std::atomic<bool> failed_{false};
+    SpinLock error_lock_;
+    std::exception_ptr error_;
+};
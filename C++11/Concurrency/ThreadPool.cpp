@@ -1,36 +1,188 @@
 #include <vector>
 #include <thread>
 #include <future>
-#include <queue>
+#include <deque>
 #include <mutex>
 #include <condition_variable>
 #include <functional>
 #include <stdexcept>
 #include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <new>
+#include <queue>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+
+#include "PoolTrace.hpp"   // -DULLTP_ENABLE_TRACE=1 to record task events
+
+// Move-only type-erased void() callable. Callables up to kInline bytes
+// (a packaged_task plus a few captures) live in the object itself, so
+// unlike std::function wrapping a move-only task there is no extra
+// allocation per submit.
+class Task {
+public:
+    static constexpr size_t kInline = 48;
+
+    Task() noexcept = default;
+
+    template <class F, class D = std::decay_t<F>,
+              class = std::enable_if_t<!std::is_same<D, Task>::value>>
+    Task(F&& f) {
+        if (sizeof(D) <= kInline && alignof(D) <= alignof(std::max_align_t) &&
+            std::is_nothrow_move_constructible<D>::value) {
+            new (buf_) D(std::forward<F>(f));
+            ops_ = &inline_ops<D>;
+        } else {
+            *reinterpret_cast<D**>(buf_) = new D(std::forward<F>(f));
+            ops_ = &heap_ops<D>;
+        }
+    }
+
+    Task(Task&& o) noexcept : ops_(o.ops_) {
+        if (ops_) ops_->move(buf_, o.buf_);
+        o.ops_ = nullptr;
+    }
+
+    Task& operator=(Task&& o) noexcept {
+        if (this != &o) {
+            reset();
+            ops_ = o.ops_;
+            if (ops_) ops_->move(buf_, o.buf_);
+            o.ops_ = nullptr;
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() { reset(); }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+    void operator()() { ops_->call(buf_); }
+
+private:
+    struct Ops {
+        void (*call)(void*);
+        void (*move)(void* dst, void* src) noexcept; // leaves src destroyed
+        void (*destroy)(void*) noexcept;
+    };
+
+    template <class D>
+    static constexpr Ops inline_ops = {
+        [](void* p) { (*static_cast<D*>(p))(); },
+        [](void* dst, void* src) noexcept {
+            new (dst) D(std::move(*static_cast<D*>(src)));
+            static_cast<D*>(src)->~D();
+        },
+        [](void* p) noexcept { static_cast<D*>(p)->~D(); },
+    };
+
+    template <class D>
+    static constexpr Ops heap_ops = {
+        [](void* p) { (**static_cast<D**>(p))(); },
+        [](void* dst, void* src) noexcept { std::memcpy(dst, src, sizeof(D*)); },
+        [](void* p) noexcept { delete *static_cast<D**>(p); },
+    };
+
+    void reset() noexcept {
+        if (ops_) ops_->destroy(buf_);
+        ops_ = nullptr;
+    }
+
+    alignas(std::max_align_t) unsigned char buf_[kInline];
+    const Ops* ops_ = nullptr;
+};
+
+// Bounded MPMC ring (Vyukov) of Tasks; one per worker. The owner pops,
+// idle peers steal, any thread pushes.
+class TaskRing {
+public:
+    explicit TaskRing(size_t capacity_pow2) : mask_(capacity_pow2 - 1), cells_(capacity_pow2) {
+        for (size_t i = 0; i < cells_.size(); ++i) cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    bool push(Task& t) noexcept {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        Cell* c;
+        for (;;) {
+            c = &cells_[pos & mask_];
+            size_t seq = c->seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if (dif == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (dif < 0) {
+                return false; // full
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        c->task = std::move(t);
+        c->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
 
+    bool pop(Task& out) noexcept {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        Cell* c;
+        for (;;) {
+            c = &cells_[pos & mask_];
+            size_t seq = c->seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (dif == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (dif < 0) {
+                return false; // empty
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        out = std::move(c->task);
+        c->seq.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const noexcept {
+        return head_.load(std::memory_order_relaxed) >= tail_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        Task task;
+    };
+
+    const size_t mask_;
+    std::vector<Cell> cells_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+// Same submit() as before, new engine:
+//   - one TaskRing per worker; submitters spread round-robin (a worker
+//     submitting feeds its own ring), idle workers steal from the others,
+//     and a mutex-protected deque takes the overflow so submit never fails;
+//   - Task instead of std::function: the packaged_task is the only
+//     allocation per submit;
+//   - workers still block on a condition variable when idle, but submit()
+//     only touches the mutex/notify when some worker is actually asleep.
 class ThreadPool {
 public:
-    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency())
+    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency(),
+                        size_t ring_capacity_pow2 = 1024)
         : stop_(false)
     {
         if (threads == 0) threads = 1; // Fallback
+        for (size_t i = 0; i < threads; ++i)
+            rings_.emplace_back(new TaskRing(ring_capacity_pow2));
         for (size_t i = 0; i < threads; ++i) {
-            workers_.emplace_back([this] {
-                for (;;) {
-                    std::function<void()> task;
-                    {
-                        std::unique_lock<std::mutex> lock(this->queue_mutex_);
-                        this->condition_.wait(lock, [this] {
-                            return this->stop_ || !this->tasks_.empty();
-                        });
-                        if (this->stop_ && this->tasks_.empty())
-                            return;
-                        task = std::move(this->tasks_.front());
-                        this->tasks_.pop();
-                    }
-                    task();
-                }
+            workers_.emplace_back([this, i] {
+                ULLTP_TRACE_THREAD(("pool-" + std::to_string(i)).c_str());
+                worker_loop(i);
             });
         }
     }
@@ -42,41 +194,242 @@ public:
     {
         using return_type = typename std::invoke_result<F, Args...>::type;
 
-        auto task = std::make_shared<std::packaged_task<return_type()>>(
+        std::packaged_task<return_type()> task(
             std::bind(std::forward<F>(f), std::forward<Args>(args)...)
         );
+        std::future<return_type> res = task.get_future();
+
+        if (stop_.load(std::memory_order_relaxed)) throw std::runtime_error("ThreadPool is stopped");
+#if ULLTP_ENABLE_TRACE
+        const char* tag = typeid(F).name(); // trace label
+        Task t([task = std::move(task), tag]() mutable {
+            ULLTP_TRACE_NAMED(Start, tag);
+            task();
+            ULLTP_TRACE_NAMED(End, tag);
+        });
+        enqueue(t);
+        ULLTP_TRACE_NAMED(Enqueue, tag);
+#else
+        // No tag in the closure: it would take 8 of Task's inline bytes.
+        Task t([task = std::move(task)]() mutable { task(); });
+        enqueue(t);
+#endif
+        wake_one();
+        return res;
+    }
+
+    // Run one queued task on the calling thread; false if there was none.
+    bool run_one() {
+        Task task;
+        size_t me = self().pool == this ? self().index : 0;
+        if (!try_get(me, task)) return false;
+        ULLTP_TRACE_NAMED(Dequeue, "task");
+        task();
+        return true;
+    }
+
+    // Run queued tasks on the calling thread until ready() holds, so a task
+    // waiting on its own sub-tasks keeps the pool busy instead of blocking
+    // a worker (or deadlocking a pool whose workers all wait).
+    template <class Pred>
+    void help_until(Pred&& ready) {
+        for (unsigned idle = 0; !ready();) {
+            if (run_one()) {
+                idle = 0;
+            } else if (++idle >= kSpins) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // future.get() that helps while the result is pending.
+    template <class T>
+    T wait(std::future<T>& f) {
+        help_until([&] { return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+        return f.get();
+    }
+
+    ~ThreadPool() {
+        {
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            stop_ = true;
+        }
+        condition_.notify_all();
+        for (std::thread &worker : workers_)
+            if (worker.joinable())
+                worker.join();
+    }
+
+private:
+    static constexpr unsigned kSpins = 64;
+
+    struct WorkerId {
+        const ThreadPool* pool = nullptr;
+        size_t index = 0;
+    };
+
+    static WorkerId& self() noexcept {
+        thread_local WorkerId id;
+        return id;
+    }
+
+    void enqueue(Task& t) {
+        const size_t n = rings_.size();
+        size_t start;
+        if (self().pool == this) {
+            start = self().index;
+        } else {
+            thread_local size_t rr = std::hash<std::thread::id>()(std::this_thread::get_id());
+            start = rr++;
+        }
+        for (size_t i = 0; i < n; ++i)
+            if (rings_[(start + i) % n]->push(t)) return;
+        std::lock_guard<std::mutex> lock(overflow_mutex_);
+        overflow_.push_back(std::move(t));
+        overflow_size_.store(overflow_.size(), std::memory_order_release);
+    }
+
+    // Pairs with the fence in sleep(): either we see the sleeper or it sees
+    // our task, so busy pools never touch the mutex.
+    void wake_one() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_relaxed) == 0) return;
+        { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+        condition_.notify_one();
+    }
+
+    bool try_get(size_t me, Task& t) {
+        const size_t n = rings_.size();
+        for (size_t i = 0; i < n; ++i)
+            if (rings_[(me + i) % n]->pop(t)) return true;
+        if (overflow_size_.load(std::memory_order_acquire) == 0) return false;
+        std::lock_guard<std::mutex> lock(overflow_mutex_);
+        if (overflow_.empty()) return false;
+        t = std::move(overflow_.front());
+        overflow_.pop_front();
+        overflow_size_.store(overflow_.size(), std::memory_order_release);
+        return true;
+    }
+
+    bool has_work() const {
+        for (const auto& r : rings_)
+            if (!r->empty()) return true;
+        return overflow_size_.load(std::memory_order_acquire) != 0;
+    }
+
+    void worker_loop(size_t me) {
+        self() = WorkerId{this, me};
+        unsigned spins = 0;
+        for (;;) {
+            Task task;
+            if (try_get(me, task)) {
+                ULLTP_TRACE_NAMED(Dequeue, "task");
+                spins = 0;
+                task();
+                continue;
+            }
+            if (++spins < kSpins) {
+                std::this_thread::yield();
+                continue;
+            }
+            spins = 0;
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            sleepers_.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            condition_.wait(lock, [this] { return stop_ || has_work(); });
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+            if (stop_ && !has_work())
+                return;
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::vector<std::unique_ptr<TaskRing>> rings_;
+
+    std::mutex overflow_mutex_;
+    std::deque<Task> overflow_;
+    std::atomic<size_t> overflow_size_{0};
+
+    std::mutex sleep_mutex_;
+    std::condition_variable condition_;
+    alignas(64) std::atomic<unsigned> sleepers_{0};
+    std::atomic<bool> stop_;
+};
+
+// The previous engine (one mutex, std::function, notify on every submit),
+// kept for the throughput comparison below.
+class MutexThreadPool {
+public:
+    explicit MutexThreadPool(size_t threads) : stop_(false) {
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] {
+                for (;;) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(queue_mutex_);
+                        condition_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                        if (stop_ && tasks_.empty()) return;
+                        task = std::move(tasks_.front());
+                        tasks_.pop();
+                    }
+                    task();
+                }
+            });
+        }
+    }
 
+    template<class F, class... Args>
+    auto submit(F&& f, Args&&... args) -> std::future<typename std::invoke_result<F, Args...>::type> {
+        using return_type = typename std::invoke_result<F, Args...>::type;
+        auto task = std::make_shared<std::packaged_task<return_type()>>(
+            std::bind(std::forward<F>(f), std::forward<Args>(args)...));
         std::future<return_type> res = task->get_future();
         {
             std::unique_lock<std::mutex> lock(queue_mutex_);
-            if (stop_) throw std::runtime_error("ThreadPool is stopped");
-            tasks_.emplace([task](){ (*task)(); });
+            tasks_.emplace([task]() { (*task)(); });
         }
         condition_.notify_one();
         return res;
     }
 
-    ~ThreadPool() {
+    ~MutexThreadPool() {
         {
             std::unique_lock<std::mutex> lock(queue_mutex_);
             stop_ = true;
         }
         condition_.notify_all();
-        for (std::thread &worker : workers_)
-            if (worker.joinable())
-                worker.join();
+        for (std::thread &worker : workers_) worker.join();
     }
 
 private:
     std::vector<std::thread> workers_;
     std::queue<std::function<void()>> tasks_;
-
     std::mutex queue_mutex_;
     std::condition_variable condition_;
-    std::atomic<bool> stop_;
+    bool stop_;
 };
 
-int main() {
+// Submits per second from 'producers' threads into a pool of 'threads'.
+template <class Pool>
+double submit_rate(size_t threads, size_t producers, size_t per_producer) {
+    Pool pool(threads);
+    std::vector<std::vector<std::future<int>>> futs(producers);
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> ps;
+    for (size_t p = 0; p < producers; ++p) {
+        ps.emplace_back([&, p] {
+            futs[p].reserve(per_producer);
+            for (size_t i = 0; i < per_producer; ++i) futs[p].push_back(pool.submit([i] { return int(i); }));
+        });
+    }
+    for (auto& t : ps) t.join();
+    auto t1 = std::chrono::steady_clock::now();
+    for (auto& v : futs)
+        for (auto& f : v) f.get();
+    return producers * per_producer / std::chrono::duration<double>(t1 - t0).count();
+}
+
+int main(int argc, char** argv) {
     ThreadPool pool(4); // 4 worker threads
 
     auto f1 = pool.submit([] { return 42; });
@@ -85,6 +438,26 @@ int main() {
     std::cout << "f1 result: " << f1.get() << "\n";  // 42
     std::cout << "f2 result: " << f2.get() << "\n";  // 12
 
+    // Nested fork-join: every task waits on a child, which with plain
+    // get() would leave all 4 workers blocked.
+    std::function<long(int)> fib = [&](int n) -> long {
+        if (n < 2) return n;
+        auto child = pool.submit(fib, n - 1);
+        long b = fib(n - 2);
+        return pool.wait(child) + b;
+    };
+    auto f3 = pool.submit(fib, 20);
+    std::cout << "fib(20): " << pool.wait(f3) << "\n";  // 6765
+
+    // ./a.out bench [threads]: submit throughput, old vs new engine.
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        size_t threads = argc > 2 ? std::stoul(argv[2]) : 8;
+        double old_rate = submit_rate<MutexThreadPool>(threads, threads, 200000);
+        double new_rate = submit_rate<ThreadPool>(threads, threads, 200000);
+        std::cout << threads << " threads: mutex pool " << old_rate / 1e6 << "M submits/s, ring pool "
+                  << new_rate / 1e6 << "M submits/s (" << new_rate / old_rate << "x)\n";
+    }
+
     // Pool destructor will automatically join threads
     return 0;
 }
@@ -1,10 +1,15 @@
-
-
 #include <iostream>
 #include <queue>
 #include <mutex>
 #include <condition_variable>
 #include <thread>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
 
 template <typename T>
 class ThreadSafeQueue
@@ -20,7 +25,12 @@ public:
     /** */
     ThreadSafeQueue(ThreadSafeQueue const &other);
     /** */
-    void push(T newValue);
+    void push(const T &newValue);
+    /** */
+    void push(T &&newValue);
+    /** */
+    template <typename... Args>
+    void emplace(Args &&...args);
     /** */
     void waitAndPop(T &value);
     /** */
@@ -29,6 +39,20 @@ public:
     bool try_pop(T &value);
     /** */
     std::shared_ptr<T> try_pop();
+    /**
+     * Moves the whole backlog to the end of 'out'; the queue is only locked
+     * for a swap. Returns the number of items moved.
+     */
+    size_t drain(std::vector<T> &out);
+    /** */
+    std::vector<T> pop_all();
+    /**
+     * Waits up to 'timeout' for the queue to become non-empty, then moves up
+     * to 'max' items to the end of 'out' under the same lock. Returns the
+     * number moved, 0 on timeout.
+     */
+    template <typename Rep, typename Period>
+    size_t wait_pop_bulk(std::vector<T> &out, size_t max, std::chrono::duration<Rep, Period> timeout);
     /** */
     bool empty() const;
 };
@@ -41,10 +65,23 @@ ThreadSafeQueue<T>::ThreadSafeQueue(ThreadSafeQueue const &other)
 }
 
 template <typename T>
-void ThreadSafeQueue<T>::push(T newValue)
+void ThreadSafeQueue<T>::push(const T &newValue)
+{
+    emplace(newValue);
+}
+
+template <typename T>
+void ThreadSafeQueue<T>::push(T &&newValue)
+{
+    emplace(std::move(newValue));
+}
+
+template <typename T>
+template <typename... Args>
+void ThreadSafeQueue<T>::emplace(Args &&...args)
 {
     std::lock_guard<std::mutex> lock(m_mtx);
-    m_queue.push(newValue);
+    m_queue.emplace(std::forward<Args>(args)...);
     m_condVar.notify_one();
 }
 
@@ -54,7 +91,7 @@ void ThreadSafeQueue<T>::waitAndPop(T &value)
     std::unique_lock<std::mutex> lock(m_mtx);
     m_condVar.wait(lock, [this]
                    { return !m_queue.empty(); });
-    value = m_queue.front();
+    value = std::move(m_queue.front());
     m_queue.pop();
 }
 
@@ -64,7 +101,7 @@ std::shared_ptr<T> ThreadSafeQueue<T>::waitAndPop()
     std::unique_lock<std::mutex> lock(m_mtx);
     m_condVar.wait(lock, [this]
                    { return !m_queue.empty(); });
-    auto result = std::make_shared<T>(m_queue.front());
+    auto result = std::make_shared<T>(std::move(m_queue.front()));
     m_queue.pop();
     return result;
 }
@@ -73,10 +110,10 @@ template <typename T>
 bool ThreadSafeQueue<T>::try_pop(T &value)
 {
     std::lock_guard<std::mutex> lock(m_mtx);
-    if (!m_queue.empty())
+    if (m_queue.empty())
         return false;
 
-    value = m_queue.front();
+    value = std::move(m_queue.front());
     m_queue.pop();
     return true;
 }
@@ -85,14 +122,55 @@ template <typename T>
 std::shared_ptr<T> ThreadSafeQueue<T>::try_pop()
 {
     std::lock_guard<std::mutex> lock(m_mtx);
-    if (!m_queue.empty())
-        return std::make_shared<T>();
+    if (m_queue.empty())
+        return std::shared_ptr<T>();
 
-    auto result = std::make_shared<T>(m_queue.front());
+    auto result = std::make_shared<T>(std::move(m_queue.front()));
     m_queue.pop();
     return result;
 }
 
+template <typename T>
+size_t ThreadSafeQueue<T>::drain(std::vector<T> &out)
+{
+    std::queue<T> backlog;
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        backlog.swap(m_queue);
+    }
+    size_t n = backlog.size();
+    out.reserve(out.size() + n);
+    for (; !backlog.empty(); backlog.pop())
+        out.push_back(std::move(backlog.front()));
+    return n;
+}
+
+template <typename T>
+std::vector<T> ThreadSafeQueue<T>::pop_all()
+{
+    std::vector<T> out;
+    drain(out);
+    return out;
+}
+
+template <typename T>
+template <typename Rep, typename Period>
+size_t ThreadSafeQueue<T>::wait_pop_bulk(std::vector<T> &out, size_t max,
+                                         std::chrono::duration<Rep, Period> timeout)
+{
+    std::unique_lock<std::mutex> lock(m_mtx);
+    if (!m_condVar.wait_for(lock, timeout, [this]
+                            { return !m_queue.empty(); }))
+        return 0;
+    size_t n = 0;
+    for (; n < max && !m_queue.empty(); ++n)
+    {
+        out.push_back(std::move(m_queue.front()));
+        m_queue.pop();
+    }
+    return n;
+}
+
 template <typename T>
 bool ThreadSafeQueue<T>::empty() const
 {
@@ -100,6 +178,255 @@ bool ThreadSafeQueue<T>::empty() const
     return m_queue.empty();
 }
 
+/**
+ * Two-lock queue over the dummy-node list of SimpleQueueUsingLinkList.cpp.
+ * push() only touches the tail and pop only the head, and the dummy node
+ * keeps them on different nodes, so producers and consumers take different
+ * mutexes and don't serialize on each other.
+ *
+ * An atomic element count publishes pushed nodes to the consumers. A
+ * producer only takes the head mutex to wake a consumer when it moves the
+ * count off zero and someone is waiting; a woken consumer that sees more
+ * items passes the wakeup on.
+ *
+ * Values live in the node itself rather than in a make_shared<T>, and
+ * popped nodes are recycled: the consumer side collects them and hands
+ * them back to the producer side a batch at a time, so a warmed-up queue
+ * doesn't allocate. The queue keeps its high-water mark of nodes until it
+ * is destroyed.
+ */
+template <typename T>
+class FineGrainedQueue
+{
+private:
+    struct node
+    {
+        alignas(T) unsigned char storage[sizeof(T)];
+        node *next = nullptr;
+
+        T *value() { return std::launder(reinterpret_cast<T *>(storage)); }
+    };
+
+    static constexpr size_t kRecycleBatch = 64;
+
+    // Consumer side, under m_headMutex.
+    alignas(64) mutable std::mutex m_headMutex;
+    node *m_head;
+    node *m_recycled = nullptr;
+    node *m_recycledLast = nullptr;
+    size_t m_recycledCount = 0;
+    std::condition_variable m_dataCond;
+    std::atomic<unsigned> m_waiters{0};
+
+    // Producer side, under m_tailMutex.
+    alignas(64) std::mutex m_tailMutex;
+    node *m_tail;
+    node *m_spare = nullptr;
+
+    alignas(64) std::atomic<size_t> m_count{0};
+    // Recycled batches on their way from the consumer to the producer side.
+    std::atomic<node *> m_returned{nullptr};
+
+    node *acquireNode()
+    {
+        if (!m_spare)
+            m_spare = m_returned.exchange(nullptr, std::memory_order_acquire);
+        if (!m_spare)
+            return new node;
+        node *n = m_spare;
+        m_spare = n->next;
+        n->next = nullptr;
+        return n;
+    }
+
+    void recycleNode(node *n)
+    {
+        n->next = m_recycled;
+        m_recycled = n;
+        if (!m_recycledLast)
+            m_recycledLast = n;
+        if (++m_recycledCount < kRecycleBatch)
+            return;
+        node *&link = m_recycledLast->next;
+        link = m_returned.load(std::memory_order_relaxed);
+        while (!m_returned.compare_exchange_weak(link, m_recycled, std::memory_order_release,
+                                                 std::memory_order_relaxed))
+            ;
+        m_recycled = m_recycledLast = nullptr;
+        m_recycledCount = 0;
+    }
+
+    // Under the head mutex, queue not empty.
+    T takeHead()
+    {
+        node *old = m_head;
+        T value(std::move(*old->value()));
+        old->value()->~T();
+        m_head = old->next;
+        recycleNode(old);
+        if (m_count.fetch_sub(1, std::memory_order_seq_cst) > 1 &&
+            m_waiters.load(std::memory_order_seq_cst) != 0)
+            m_dataCond.notify_one();
+        return value;
+    }
+
+    // Under the head mutex; false if 'deadline' passed first. The waiter
+    // counts itself before re-checking the count and push() bumps the
+    // count before checking for waiters (all seq_cst), so one of the two
+    // sees the other; a notifying producer takes the head mutex, which
+    // closes the gap between the check and the sleep.
+    bool waitForData(std::unique_lock<std::mutex> &lock,
+                     const std::chrono::steady_clock::time_point *deadline = nullptr)
+    {
+        if (m_count.load(std::memory_order_acquire) != 0)
+            return true;
+        m_waiters.fetch_add(1, std::memory_order_seq_cst);
+        auto ready = [this]
+        { return m_count.load(std::memory_order_seq_cst) != 0; };
+        bool ok = true;
+        if (deadline)
+            ok = m_dataCond.wait_until(lock, *deadline, ready);
+        else
+            m_dataCond.wait(lock, ready);
+        m_waiters.fetch_sub(1, std::memory_order_relaxed);
+        return ok;
+    }
+
+    static void freeList(node *n)
+    {
+        while (n)
+        {
+            node *next = n->next;
+            delete n;
+            n = next;
+        }
+    }
+
+public:
+    /** 'reserve' nodes are preallocated for push(). */
+    explicit FineGrainedQueue(size_t reserve = 0);
+    FineGrainedQueue(const FineGrainedQueue &) = delete;
+    FineGrainedQueue &operator=(const FineGrainedQueue &) = delete;
+    /** */
+    ~FineGrainedQueue();
+    /** */
+    void push(T newValue) { emplace(std::move(newValue)); }
+    /** */
+    template <typename... Args>
+    void emplace(Args &&...args);
+    /** */
+    void waitAndPop(T &value);
+    /** */
+    T waitAndPop();
+    /** False if nothing arrived within 'timeout'. */
+    template <typename Rep, typename Period>
+    bool waitAndPop(T &value, std::chrono::duration<Rep, Period> timeout);
+    /** */
+    bool try_pop(T &value);
+    /** */
+    bool empty() const { return size() == 0; }
+    /** */
+    size_t size() const { return m_count.load(std::memory_order_acquire); }
+};
+
+template <typename T>
+FineGrainedQueue<T>::FineGrainedQueue(size_t reserve) : m_head(new node), m_tail(m_head)
+{
+    for (size_t i = 0; i < reserve; ++i)
+    {
+        node *n = new node;
+        n->next = m_spare;
+        m_spare = n;
+    }
+}
+
+template <typename T>
+FineGrainedQueue<T>::~FineGrainedQueue()
+{
+    while (m_head != m_tail)
+    {
+        node *n = m_head;
+        n->value()->~T();
+        m_head = n->next;
+        delete n;
+    }
+    delete m_tail;
+    freeList(m_recycled);
+    freeList(m_spare);
+    freeList(m_returned.load(std::memory_order_relaxed));
+}
+
+template <typename T>
+template <typename... Args>
+void FineGrainedQueue<T>::emplace(Args &&...args)
+{
+    size_t before;
+    {
+        std::lock_guard<std::mutex> lock(m_tailMutex);
+        node *fresh = acquireNode();
+        // The value goes into the current dummy node, the new node becomes
+        // the dummy.
+        try
+        {
+            new (m_tail->storage) T(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            fresh->next = m_spare;
+            m_spare = fresh;
+            throw;
+        }
+        m_tail->next = fresh;
+        m_tail = fresh;
+        before = m_count.fetch_add(1, std::memory_order_seq_cst);
+    }
+    if (before == 0 && m_waiters.load(std::memory_order_seq_cst) != 0)
+    {
+        std::lock_guard<std::mutex> lock(m_headMutex);
+        m_dataCond.notify_one();
+    }
+}
+
+template <typename T>
+void FineGrainedQueue<T>::waitAndPop(T &value)
+{
+    std::unique_lock<std::mutex> lock(m_headMutex);
+    waitForData(lock);
+    value = takeHead();
+}
+
+template <typename T>
+T FineGrainedQueue<T>::waitAndPop()
+{
+    std::unique_lock<std::mutex> lock(m_headMutex);
+    waitForData(lock);
+    return takeHead();
+}
+
+template <typename T>
+template <typename Rep, typename Period>
+bool FineGrainedQueue<T>::waitAndPop(T &value, std::chrono::duration<Rep, Period> timeout)
+{
+    std::chrono::steady_clock::time_point deadline =
+        std::chrono::steady_clock::now() +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
+    std::unique_lock<std::mutex> lock(m_headMutex);
+    if (!waitForData(lock, &deadline))
+        return false;
+    value = takeHead();
+    return true;
+}
+
+template <typename T>
+bool FineGrainedQueue<T>::try_pop(T &value)
+{
+    std::lock_guard<std::mutex> lock(m_headMutex);
+    if (m_count.load(std::memory_order_acquire) == 0)
+        return false;
+    value = takeHead();
+    return true;
+}
+
 void WriterThread(ThreadSafeQueue<int> &queue)
 {
     for (int i = 1; i <= 40; i++)
@@ -117,8 +444,86 @@ void ReaderThread(ThreadSafeQueue<int> &queue)
     }
 }
 
-int main()
+// Producers push 'items' ints between them, consumers pop them all;
+// returns items per second.
+template <typename Queue>
+double Throughput(int producers, int consumers, int items)
+{
+    Queue queue;
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int p = 0; p < producers; p++)
+        threads.emplace_back([&queue, p, producers, items]
+                             {
+                                 for (int i = p; i < items; i += producers)
+                                     queue.push(i); });
+    for (int c = 0; c < consumers; c++)
+        threads.emplace_back([&queue, c, consumers, items]
+                             {
+                                 int value;
+                                 for (int i = c; i < items; i += consumers)
+                                     queue.waitAndPop(value); });
+    for (auto &t : threads)
+        t.join();
+    std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+    return items / secs.count();
+}
+
+// Producers feed one consumer that takes up to 'batch' items per lock
+// (1: waitAndPop); returns items per second and the lock round trips.
+double FanInThroughput(int producers, int items, size_t batch, long &takes)
 {
+    ThreadSafeQueue<std::string> queue;
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int p = 0; p < producers; p++)
+        threads.emplace_back([&queue, p, producers, items]
+                             {
+                                 for (int i = p; i < items; i += producers)
+                                     queue.emplace("event " + std::to_string(i)); });
+    takes = 0;
+    std::string value;
+    std::vector<std::string> events;
+    for (int got = 0; got < items; takes++)
+    {
+        if (batch == 1)
+        {
+            queue.waitAndPop(value);
+            got++;
+            continue;
+        }
+        events.clear();
+        got += queue.wait_pop_bulk(events, batch, std::chrono::milliseconds(1));
+    }
+    for (auto &t : threads)
+        t.join();
+    std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+    return items / secs.count();
+}
+
+int main(int argc, char **argv)
+{
+    // ./a.out bench: one-mutex queue vs two-lock queue, N producers x N consumers.
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        const int items = 2000000;
+        for (int n : {1, 2, 4, 8})
+        {
+            double one = Throughput<ThreadSafeQueue<int>>(n, n, items);
+            double two = Throughput<FineGrainedQueue<int>>(n, n, items);
+            std::cout << n << "x" << n << ": one mutex " << one / 1e6 << "M/s, two locks "
+                      << two / 1e6 << "M/s (" << two / one << "x)" << std::endl;
+        }
+        // 4 producers -> 1 consumer, per-item pops vs bulk pops.
+        long single_takes, bulk_takes;
+        double single = FanInThroughput(4, items, 1, single_takes);
+        double bulk = FanInThroughput(4, items, 256, bulk_takes);
+        std::cout << "fan-in 4x1: waitAndPop " << single / 1e6 << "M/s (" << single_takes
+                  << " pops), wait_pop_bulk " << bulk / 1e6 << "M/s (" << bulk_takes << " pops)"
+                  << std::endl;
+        return 0;
+    }
+
     ThreadSafeQueue<int> ts_Queue;
 
     std::thread t1(WriterThread, std::ref(ts_Queue));
@@ -134,4 +539,21 @@ int main()
     std::cout << i << std::endl;
     std::cout << *ts_Queue.waitAndPop() << std::endl;
     std::cout << "Empty : " << std::boolalpha << ts_Queue.empty() << std::endl;
-}
\ No newline at end of file
+
+    for (int i = 0; i < 5; i++)
+        ts_Queue.push(i * i);
+    for (int value : ts_Queue.pop_all())
+        std::cout << "Drained : " << value << std::endl;
+
+    FineGrainedQueue<std::string> fg_Queue;
+    std::thread producer([&fg_Queue]
+                         {
+                             for (int i = 1; i <= 5; i++)
+                                 fg_Queue.emplace(3, char('a' + i)); });
+    for (int i = 1; i <= 5; i++)
+        std::cout << "FineGrainedQueue pop : " << fg_Queue.waitAndPop() << std::endl;
+    producer.join();
+    std::string s;
+    std::cout << "Timed pop : " << std::boolalpha
+              << fg_Queue.waitAndPop(s, std::chrono::milliseconds(10)) << std::endl;
+}
@@ -5,6 +5,11 @@
 #include <stack>
 #include <exception>
 #include <memory>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../../LowLatencyDataStruct/LockFreeStack.hpp"
 
 struct EmptyStack : std::exception
 {
@@ -76,8 +81,60 @@ void TestThreadSafeStackTask(int id, ThreadSafeStack<int> &obj)
     }
 }
 
-int main()
+// Every thread pushes then pops 'pairs' times; returns pairs per second.
+// A thread always pops after its own push, so the stack is never empty.
+template <typename Push, typename Pop>
+double PairRate(int threads, int pairs, Push push, Pop pop)
+{
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++)
+        workers.emplace_back([&, t]
+                             {
+                                 for (int i = 0; i < pairs; i++)
+                                 {
+                                     push(t * pairs + i);
+                                     pop();
+                                 } });
+    for (auto &w : workers)
+        w.join();
+    std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+    return threads * double(pairs) / secs.count();
+}
+
+void Bench()
 {
+    const int pairs = 200000;
+    for (int threads : {1, 2, 4, 8, 16, 32})
+    {
+        ThreadSafeStack<int> locked;
+        LockFreeStack<int> lockFree;
+        LockFreeStack<int> eliminating(threads / 2 + 1);
+        int value;
+        double m = PairRate(threads, pairs / threads, [&](int v)
+                            { locked.push(v); }, [&]
+                            { locked.pop(value); });
+        double lf = PairRate(threads, pairs / threads, [&](int v)
+                             { lockFree.push(v); }, [&]
+                             { lockFree.try_pop(); });
+        double el = PairRate(threads, pairs / threads, [&](int v)
+                             { eliminating.push(v); }, [&]
+                             { eliminating.try_pop(); });
+        std::cout << threads << " threads: mutex " << m / 1e6 << "M pairs/s, lock-free "
+                  << lf / 1e6 << "M (" << lf / m << "x), with elimination " << el / 1e6 << "M ("
+                  << el / m << "x)" << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    // ./a.out bench: mutex stack vs LockFreeStack, 1 to 32 threads.
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        Bench();
+        return 0;
+    }
+
     ThreadSafeStack<int> obj;
     obj.push(1);
     obj.push(2);
@@ -91,4 +148,12 @@ int main()
 
     t1.join();
     t2.join();
+
+    // LockFreeStack reports empty with an empty optional instead of throwing.
+    LockFreeStack<std::string> lockFree;
+    lockFree.push("lock-free");
+    auto top = lockFree.try_pop();
+    std::cout << "LockFreeStack pop : " << *top << std::endl;
+    std::cout << "LockFreeStack pop on empty : " << std::boolalpha
+              << lockFree.try_pop().has_value() << std::endl;
 }
@@ -0,0 +1,31 @@
+#include <iostream>
+
+#include "TimerWheel.hpp"
+
+int main() {
+    LowLatencyThreadPool pool(2);
+    TimerWheel timers(pool);
+
+    auto t0 = TimerWheel::Clock::now();
+    auto since = [t0] {
+        return std::chrono::duration_cast<std::chrono::microseconds>(TimerWheel::Clock::now() - t0).count();
+    };
+
+    timers.schedule_after(std::chrono::milliseconds(5), [&] {
+        std::cout << "one-shot after " << since() << "us\n";
+    });
+
+    std::atomic<int> ticks{0};
+    TimerId every = timers.schedule_every(std::chrono::microseconds(100), [&] { ++ticks; });
+
+    // Order timeout that gets cancelled before it fires
+    TimerId timeout = timers.schedule_after(std::chrono::milliseconds(50), [] {
+        std::cout << "never printed\n";
+    });
+    std::cout << "cancel timeout: " << std::boolalpha << timers.cancel(timeout) << "\n";
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    timers.cancel(every);
+    std::cout << "periodic ran " << ticks.load() << " times in ~20ms\n";
+    std::cout << "pending=" << timers.pending() << " fired=" << timers.fired() << "\n";
+}
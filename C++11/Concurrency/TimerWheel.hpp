@@ -0,0 +1,472 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "LowLatencyThreadPool.hpp"
+
+// ------------------ Hierarchical timing wheel --------------------
+// Varghese/Lauck style wheel: kLevels levels of 64 slots, each level 64x
+// coarser than the one below. A timer lives in the level of the highest
+// 6-bit digit in which its expiry tick differs from the current tick, so
+// insert and cancel are O(1) list operations on a preallocated node slab.
+// Per-level occupancy bitmaps let advance() jump straight to the next
+// non-empty slot instead of walking every tick. A timer whose expiry lies
+// past the next 2^36-tick boundary (it differs from the current tick above
+// the top level) waits in an overflow list and is linked in again when the
+// wheel reaches that boundary; one still further out goes back to the list
+// until a later boundary. Delays therefore have no limit short of the
+// 64-bit tick count, however fine the tick.
+//
+// Due timers are not run on the timer thread: their Job goes straight into
+// the pool (enqueue_raw on the timer's lane).
+//
+// Driven either by an internal timer thread (sleeps until close to the next
+// deadline, then spins for accuracy) or manually through poll(), e.g. from
+// the pool's idle hook.
+
+struct TimerWheelOptions {
+    size_t capacity = 1 << 17;                     // max pending timers (preallocated)
+    std::chrono::nanoseconds tick{1000};           // wheel resolution
+    bool timer_thread = true;                      // false = drive with poll()
+    std::chrono::nanoseconds spin_window{50000};   // timer thread spins this close to a deadline
+    std::chrono::nanoseconds max_sleep{1000000};   // upper bound on one timer-thread sleep
+};
+
+// 0 is never a valid id. Encodes slab index + generation so a stale id
+// can't cancel a recycled node.
+using TimerId = uint64_t;
+
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr unsigned kLevels = 6;   // 36 bits of ticks: ~19h at 1us
+    static constexpr unsigned kSlotBits = 6;
+    static constexpr unsigned kSlots = 1u << kSlotBits;
+
+    explicit TimerWheel(LowLatencyThreadPool& pool, const TimerWheelOptions& opts = {})
+    : pool_(pool), tick_ns_(std::max<int64_t>(1, opts.tick.count())),
+      spin_window_(opts.spin_window), max_sleep_(opts.max_sleep),
+      nodes_(opts.capacity), origin_(Clock::now())
+    {
+        for (auto& level : heads_)
+            for (auto& h : level) h = kNil;
+        for (size_t i = 0; i < nodes_.size(); ++i)
+            nodes_[i].next = i + 1 < nodes_.size() ? static_cast<uint32_t>(i + 1) : kNil;
+        free_ = nodes_.empty() ? kNil : 0;
+        due_.reserve(256);
+        if (opts.timer_thread)
+            thread_ = std::thread([this] { timer_loop(); });
+    }
+
+    ~TimerWheel() {
+        {
+            std::lock_guard<std::mutex> g(sleep_mtx_);
+            stop_.store(true, std::memory_order_release);
+            kick_ = true;
+        }
+        sleep_cv_.notify_one();
+        if (thread_.joinable()) thread_.join();
+        dispatch_due(true);
+        // Release payloads of timers that never fired, and of due ones whose
+        // lane is still full: nothing would retry them.
+        std::lock_guard<SpinLock> g(lock_);
+        for (const Due& d : due_)
+            if (d.job.deleter) d.job.deleter(d.job.data);
+        dropped_.fetch_add(due_.size(), std::memory_order_relaxed);
+        for (Node& n : nodes_)
+            if (n.armed && n.job.deleter) n.job.deleter(n.job.data);
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // --- Zero-allocation one-shot: Job semantics as in enqueue_raw ---
+    // Returns 0 if the wheel is full (deleter is *not* called then).
+    TimerId schedule_raw(Clock::time_point when, Job::Fn fn, void* data,
+                         void (*deleter)(void*) = nullptr, unsigned lane = 0) noexcept {
+        return insert(to_tick(when), 0, Job{fn, data, deleter}, lane);
+    }
+
+    // --- Callable API (one heap allocation per timer) ---
+    template <class F>
+    TimerId schedule_at(Clock::time_point when, F&& f, unsigned lane = 0) {
+        return insert_callable(to_tick(when), 0, std::forward<F>(f), lane);
+    }
+
+    template <class F>
+    TimerId schedule_after(std::chrono::nanoseconds delay, F&& f, unsigned lane = 0) {
+        return schedule_at(Clock::now() + delay, std::forward<F>(f), lane);
+    }
+
+    // First run one period from now. Missed periods (pool or timer thread
+    // stalled) are coalesced into a single run rather than replayed.
+    template <class F>
+    TimerId schedule_every(std::chrono::nanoseconds period, F&& f, unsigned lane = 0) {
+        uint64_t p = std::max<uint64_t>(1, (period.count() + tick_ns_ - 1) / tick_ns_);
+        return insert_callable(to_tick(Clock::now() + period), p, std::forward<F>(f), lane);
+    }
+
+    // True if the timer was still pending and is now removed. A periodic
+    // timer's payload is released once any run already in the pool ends.
+    bool cancel(TimerId id) noexcept {
+        uint32_t idx = static_cast<uint32_t>(id);
+        uint32_t gen = static_cast<uint32_t>(id >> 32);
+        Job dead;
+        {
+            std::lock_guard<SpinLock> g(lock_);
+            if (idx >= nodes_.size()) return false;
+            Node& n = nodes_[idx];
+            if (!n.armed || n.gen != gen) return false;
+            unlink(idx);
+            dead = n.job;
+            release_node(idx);
+        }
+        if (dead.deleter) dead.deleter(dead.data);
+        return true;
+    }
+
+    // Fire everything due by now. Safe from any thread; returns false at
+    // once if another thread is already advancing or dispatching, in which
+    // case that thread (or the next poll) picks the work up.
+    bool poll() noexcept {
+        if (!lock_.try_lock()) return false;
+        advance_locked(now_tick());
+        lock_.unlock();
+        return dispatch_due(false);
+    }
+
+    // Suitable for LowLatencyThreadPool::set_idle_hook(&TimerWheel::idle_hook, &wheel).
+    // Clear the hook before the wheel is destroyed.
+    static bool idle_hook(void* self) noexcept { return static_cast<TimerWheel*>(self)->poll(); }
+
+    size_t pending() const noexcept { return pending_.load(std::memory_order_relaxed); }
+    size_t capacity() const noexcept { return nodes_.size(); }
+    std::chrono::nanoseconds tick() const noexcept { return std::chrono::nanoseconds(tick_ns_); }
+
+    // Timers fired; dispatches that found the pool lane full and were left
+    // for the next tick; due timers released unrun because the wheel was
+    // destroyed while their lane stayed full.
+    uint64_t fired() const noexcept { return fired_.load(std::memory_order_relaxed); }
+    uint64_t dispatch_retries() const noexcept { return dispatch_retries_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    friend struct TimerWheelTestAccess;
+
+    static constexpr uint32_t kNil = UINT32_MAX;
+    static constexpr unsigned kWheelBits = kLevels * kSlotBits;
+    static constexpr uint64_t kMaxDelta = (uint64_t(1) << kWheelBits) - 1;
+    static constexpr uint8_t kOverflow = kLevels; // Node::level of the overflow list
+
+    struct Node {
+        uint64_t expiry = 0;     // absolute tick
+        uint64_t period = 0;     // ticks, 0 = one-shot
+        uint32_t prev = kNil;
+        uint32_t next = kNil;
+        uint32_t gen = 1;
+        uint8_t level = 0;
+        uint8_t slot = 0;
+        uint8_t lane = 0;
+        bool armed = false;
+        Job job;
+        void (*retain)(void*) = nullptr; // periodic: take a ref per run
+    };
+
+    // Ref-counted callable so a periodic run in flight survives cancel().
+    template <class F>
+    struct Task {
+        std::atomic<uint32_t> refs{1};
+        F fn;
+        explicit Task(F&& f) : fn(std::move(f)) {}
+        explicit Task(const F& f) : fn(f) {}
+        static void run(void* p) noexcept { static_cast<Task*>(p)->fn(); }
+        static void release(void* p) noexcept {
+            auto* t = static_cast<Task*>(p);
+            if (t->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete t;
+        }
+        static void retain(void* p) noexcept {
+            static_cast<Task*>(p)->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+    struct Due {
+        Job job;
+        unsigned lane;
+    };
+
+    template <class F>
+    TimerId insert_callable(uint64_t expiry, uint64_t period, F&& f, unsigned lane) {
+        using T = Task<std::decay_t<F>>;
+        auto* t = new T(std::forward<F>(f));
+        TimerId id = insert(expiry, period, Job{&T::run, t, &T::release}, lane,
+                            period ? &T::retain : nullptr);
+        if (!id) delete t;
+        return id;
+    }
+
+    TimerId insert(uint64_t expiry, uint64_t period, const Job& job, unsigned lane,
+                   void (*retain)(void*) = nullptr) noexcept {
+        bool kick;
+        TimerId id;
+        {
+            std::lock_guard<SpinLock> g(lock_);
+            if (free_ == kNil) return 0;
+            uint32_t idx = free_;
+            Node& n = nodes_[idx];
+            free_ = n.next;
+            n.expiry = std::max(expiry, current_ + 1);
+            n.period = period;
+            n.lane = static_cast<uint8_t>(lane);
+            n.job = job;
+            n.retain = retain;
+            n.armed = true;
+            link(idx);
+            pending_.fetch_add(1, std::memory_order_relaxed);
+            id = (static_cast<uint64_t>(n.gen) << 32) | idx;
+            // Timer thread asleep past this deadline? Wake it early.
+            kick = n.expiry < sleep_tick_;
+        }
+        if (kick) {
+            {
+                std::lock_guard<std::mutex> g(sleep_mtx_);
+                kick_ = true;
+            }
+            sleep_cv_.notify_one();
+        }
+        return id;
+    }
+
+    void release_node(uint32_t idx) noexcept {
+        Node& n = nodes_[idx];
+        n.armed = false;
+        ++n.gen;
+        if (n.gen == 0) n.gen = 1;
+        n.next = free_;
+        free_ = idx;
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Level = highest 6-bit digit where expiry and current_ differ. A timer
+    // past the next 2^36 boundary goes to the overflow list.
+    void link(uint32_t idx) noexcept {
+        Node& n = nodes_[idx];
+        uint64_t diff = n.expiry ^ current_;
+        unsigned level = diff ? (63 - __builtin_clzll(diff)) / kSlotBits : 0;
+        n.prev = kNil;
+        if (level >= kLevels) {
+            n.level = kOverflow;
+            n.slot = 0;
+            n.next = overflow_;
+            if (n.next != kNil) nodes_[n.next].prev = idx;
+            overflow_ = idx;
+            return;
+        }
+        unsigned slot = static_cast<unsigned>(n.expiry >> (level * kSlotBits)) & (kSlots - 1);
+        n.level = static_cast<uint8_t>(level);
+        n.slot = static_cast<uint8_t>(slot);
+        n.next = heads_[level][slot];
+        if (n.next != kNil) nodes_[n.next].prev = idx;
+        heads_[level][slot] = idx;
+        occupied_[level] |= uint64_t(1) << slot;
+    }
+
+    void unlink(uint32_t idx) noexcept {
+        Node& n = nodes_[idx];
+        uint32_t& head = n.level == kOverflow ? overflow_ : heads_[n.level][n.slot];
+        if (n.prev != kNil) nodes_[n.prev].next = n.next;
+        else head = n.next;
+        if (n.next != kNil) nodes_[n.next].prev = n.prev;
+        if (n.level != kOverflow && head == kNil) occupied_[n.level] &= ~(uint64_t(1) << n.slot);
+    }
+
+    // Relinks every node of the list starting at 'idx'.
+    void relink_list(uint32_t idx) noexcept {
+        while (idx != kNil) {
+            uint32_t nx = nodes_[idx].next;
+            link(idx);
+            idx = nx;
+        }
+    }
+
+    // Earliest tick > current_ at which something fires or cascades.
+    uint64_t next_event_tick() const noexcept {
+        for (unsigned l = 0; l < kLevels; ++l) {
+            unsigned shift = l * kSlotBits;
+            unsigned digit = static_cast<unsigned>(current_ >> shift) & (kSlots - 1);
+            uint64_t above = digit == kSlots - 1 ? 0 : occupied_[l] & (~uint64_t(0) << (digit + 1));
+            if (above) {
+                uint64_t block = (current_ >> (shift + kSlotBits)) << (shift + kSlotBits);
+                return block | (uint64_t(__builtin_ctzll(above)) << shift);
+            }
+        }
+        if (overflow_ != kNil) return ((current_ >> kWheelBits) + 1) << kWheelBits;
+        return UINT64_MAX;
+    }
+
+    void advance_locked(uint64_t target) noexcept {
+        while (current_ < target) {
+            uint64_t next = next_event_tick();
+            if (next > target) {
+                current_ = target;
+                return;
+            }
+            current_ = next;
+            // Reached a 2^36 boundary: overflow timers due before the next
+            // one now fit the wheel, the rest go back to the list.
+            if ((current_ & kMaxDelta) == 0 && overflow_ != kNil) {
+                uint32_t idx = overflow_;
+                overflow_ = kNil;
+                relink_list(idx);
+            }
+            // Cascade every level whose lower digits just rolled over,
+            // highest first so timers can fall through several levels.
+            for (unsigned l = kLevels - 1; l >= 1; --l) {
+                if (current_ & ((uint64_t(1) << (l * kSlotBits)) - 1)) continue;
+                unsigned slot = static_cast<unsigned>(current_ >> (l * kSlotBits)) & (kSlots - 1);
+                uint32_t idx = heads_[l][slot];
+                heads_[l][slot] = kNil;
+                occupied_[l] &= ~(uint64_t(1) << slot);
+                relink_list(idx);
+            }
+            fire_slot(static_cast<unsigned>(current_) & (kSlots - 1));
+        }
+    }
+
+    void fire_slot(unsigned slot) noexcept {
+        uint32_t idx = heads_[0][slot];
+        heads_[0][slot] = kNil;
+        occupied_[0] &= ~(uint64_t(1) << slot);
+        while (idx != kNil) {
+            Node& n = nodes_[idx];
+            uint32_t nx = n.next;
+            if (n.period) {
+                if (n.retain) n.retain(n.job.data); // ref for the run in flight
+                due_.push_back(Due{n.job, n.lane});
+                uint64_t missed = (current_ - n.expiry) / n.period;
+                n.expiry += (missed + 1) * n.period;
+                link(idx);
+            } else {
+                due_.push_back(Due{n.job, n.lane});
+                release_node(idx);
+            }
+            idx = nx;
+        }
+    }
+
+    // Outside the wheel lock so a full pool can't block schedule/cancel.
+    // One dispatcher at a time keeps due timers in firing order. Never waits
+    // for a full lane: poll() may run on the very worker that drains it, so
+    // whatever doesn't fit goes back to the front of due_ for the next tick.
+    bool dispatch_due(bool wait) noexcept {
+        if (wait) dispatch_lock_.lock();
+        else if (!dispatch_lock_.try_lock()) return false;
+        bool any = false;
+        for (;;) {
+            {
+                std::lock_guard<SpinLock> wl(lock_);
+                if (due_.empty()) break;
+                dispatching_.swap(due_);
+            }
+            size_t sent = 0;
+            while (sent < dispatching_.size()) {
+                const Due& d = dispatching_[sent];
+                if (!pool_.enqueue_raw(d.job.fn, d.job.data, d.job.deleter, d.lane)) break;
+                ++sent;
+            }
+            fired_.fetch_add(sent, std::memory_order_relaxed);
+            any |= sent != 0;
+            if (sent < dispatching_.size()) {
+                dispatch_retries_.fetch_add(1, std::memory_order_relaxed);
+                std::lock_guard<SpinLock> wl(lock_);
+                due_.insert(due_.begin(), dispatching_.begin() + sent, dispatching_.end());
+                dispatching_.clear();
+                break;
+            }
+            dispatching_.clear();
+        }
+        dispatch_lock_.unlock();
+        return any;
+    }
+
+    bool has_due() noexcept {
+        std::lock_guard<SpinLock> g(lock_);
+        return !due_.empty();
+    }
+
+    void timer_loop() noexcept {
+        while (!stop_.load(std::memory_order_acquire)) {
+            Clock::time_point wake;
+            {
+                std::lock_guard<SpinLock> g(lock_);
+                advance_locked(now_tick());
+                uint64_t next = next_event_tick();
+                // Sleep until spin_window before the next event, then spin.
+                Clock::time_point deadline = next == UINT64_MAX
+                    ? Clock::now() + max_sleep_
+                    : origin_ + std::chrono::nanoseconds(next * tick_ns_);
+                wake = std::min(deadline - spin_window_, Clock::now() + max_sleep_);
+                sleep_tick_ = wake > Clock::now() ? to_tick(wake) : 0;
+            }
+            dispatch_due(true);
+            // A full lane left timers behind: retry soon rather than sleep.
+            if (has_due()) wake = Clock::now();
+
+            if (wake > Clock::now()) {
+                std::unique_lock<std::mutex> lk(sleep_mtx_);
+                sleep_cv_.wait_until(lk, wake, [this] { return kick_; });
+                kick_ = false;
+            } else {
+                // Spin phase. yield() is nearly free on an isolated core and
+                // lets the workers run when the timer thread shares one.
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    uint64_t to_tick(Clock::time_point t) const noexcept {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t - origin_).count();
+        return ns <= 0 ? 0 : static_cast<uint64_t>(ns + tick_ns_ - 1) / tick_ns_;
+    }
+
+    uint64_t now_tick() const noexcept {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - origin_).count();
+        return static_cast<uint64_t>(ns) / tick_ns_;
+    }
+
+    LowLatencyThreadPool& pool_;
+    const int64_t tick_ns_;
+    const std::chrono::nanoseconds spin_window_;
+    const std::chrono::nanoseconds max_sleep_;
+
+    SpinLock lock_;                      // guards everything below up to due_
+    std::vector<Node> nodes_;
+    uint32_t heads_[kLevels][kSlots];
+    uint64_t occupied_[kLevels] = {};
+    uint32_t overflow_ = kNil;           // timers past the next 2^36 boundary
+    uint32_t free_ = kNil;
+    uint64_t current_ = 0;
+    uint64_t sleep_tick_ = 0;            // timer thread sleeps until here (0 = awake)
+    std::vector<Due> due_;
+
+    SpinLock dispatch_lock_;
+    std::vector<Due> dispatching_;
+
+    std::mutex sleep_mtx_;
+    std::condition_variable sleep_cv_;
+    bool kick_ = false;
+
+    const Clock::time_point origin_;
+    std::atomic<size_t> pending_{0};
+    std::atomic<uint64_t> fired_{0};
+    std::atomic<uint64_t> dispatch_retries_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+};
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "TimerWheel.hpp"
+
+// Drives the wheel's clock directly, so tests don't have to wait for it.
+struct TimerWheelTestAccess {
+    static void set_current(TimerWheel& w, uint64_t tick) {
+        std::lock_guard<SpinLock> g(w.lock_);
+        w.current_ = tick;
+    }
+    static TimerId insert_at(TimerWheel& w, uint64_t tick, Job::Fn fn, void* data) {
+        return w.insert(tick, 0, Job{fn, data, nullptr}, 0);
+    }
+    static void advance(TimerWheel& w, uint64_t tick) {
+        std::lock_guard<SpinLock> g(w.lock_);
+        w.advance_locked(tick);
+    }
+    static bool dispatch(TimerWheel& w) { return w.dispatch_due(false); }
+};
+
+static void count_run(void* p) noexcept { static_cast<std::atomic<int>*>(p)->fetch_add(1); }
+
+static TimerWheelOptions manual_options() {
+    TimerWheelOptions opts;
+    opts.capacity = 64;
+    opts.timer_thread = false;
+    return opts;
+}
+
+static void wait_for(const std::atomic<int>& counter, int value) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (counter.load() < value && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::yield();
+}
+
+// A short timer whose expiry crosses a 2^36-tick boundary
+TEST(TimerWheelTest, ExpiryAcrossTopLevelBoundary) {
+    LowLatencyThreadPool pool(1);
+    TimerWheel wheel(pool, manual_options());
+    const uint64_t boundary = uint64_t(1) << 36;
+    TimerWheelTestAccess::set_current(wheel, boundary - 10);
+
+    std::atomic<int> before{0}, after{0}, far{0};
+    ASSERT_NE(TimerWheelTestAccess::insert_at(wheel, boundary - 5, &count_run, &before), 0u);
+    ASSERT_NE(TimerWheelTestAccess::insert_at(wheel, boundary + 10, &count_run, &after), 0u);
+    ASSERT_NE(TimerWheelTestAccess::insert_at(wheel, boundary + 5000, &count_run, &far), 0u);
+    EXPECT_EQ(wheel.pending(), 3u);
+
+    TimerWheelTestAccess::advance(wheel, boundary - 5);
+    TimerWheelTestAccess::dispatch(wheel);
+    wait_for(before, 1);
+    EXPECT_EQ(before.load(), 1);
+    EXPECT_EQ(after.load(), 0);
+
+    TimerWheelTestAccess::advance(wheel, boundary + 9);
+    TimerWheelTestAccess::dispatch(wheel);
+    EXPECT_EQ(wheel.pending(), 2u);
+
+    TimerWheelTestAccess::advance(wheel, boundary + 10);
+    TimerWheelTestAccess::dispatch(wheel);
+    wait_for(after, 1);
+    EXPECT_EQ(after.load(), 1);
+    EXPECT_EQ(far.load(), 0);
+
+    TimerWheelTestAccess::advance(wheel, boundary + 5000);
+    TimerWheelTestAccess::dispatch(wheel);
+    wait_for(far, 1);
+    EXPECT_EQ(far.load(), 1);
+    EXPECT_EQ(wheel.pending(), 0u);
+}
+
+// Delays beyond the wheel's 2^36-tick span wait out whole boundaries in
+// the overflow list instead of firing early
+TEST(TimerWheelTest, DelayBeyondWheelSpan) {
+    LowLatencyThreadPool pool(1);
+    TimerWheel wheel(pool, manual_options());
+    const uint64_t span = uint64_t(1) << 36;
+    const uint64_t start = 12345;
+    TimerWheelTestAccess::set_current(wheel, start);
+
+    std::atomic<int> runs{0};
+    const uint64_t expiry = start + 3 * span + 7;
+    ASSERT_NE(TimerWheelTestAccess::insert_at(wheel, expiry, &count_run, &runs), 0u);
+
+    for (uint64_t boundary = span; boundary < expiry; boundary += span) {
+        TimerWheelTestAccess::advance(wheel, boundary);
+        TimerWheelTestAccess::dispatch(wheel);
+        EXPECT_EQ(wheel.fired(), 0u);
+        EXPECT_EQ(wheel.pending(), 1u);
+    }
+    TimerWheelTestAccess::advance(wheel, expiry - 1);
+    TimerWheelTestAccess::dispatch(wheel);
+    EXPECT_EQ(wheel.fired(), 0u);
+
+    TimerWheelTestAccess::advance(wheel, expiry);
+    TimerWheelTestAccess::dispatch(wheel);
+    wait_for(runs, 1);
+    EXPECT_EQ(runs.load(), 1);
+    EXPECT_EQ(wheel.pending(), 0u);
+}
+
+// A timer parked in the overflow list can still be cancelled
+TEST(TimerWheelTest, CancelAcrossTopLevelBoundary) {
+    LowLatencyThreadPool pool(1);
+    TimerWheel wheel(pool, manual_options());
+    const uint64_t boundary = uint64_t(1) << 36;
+    TimerWheelTestAccess::set_current(wheel, boundary - 10);
+
+    std::atomic<int> runs{0};
+    TimerId id = TimerWheelTestAccess::insert_at(wheel, boundary + 20, &count_run, &runs);
+    EXPECT_TRUE(wheel.cancel(id));
+    TimerWheelTestAccess::advance(wheel, boundary + 100);
+    TimerWheelTestAccess::dispatch(wheel);
+    EXPECT_EQ(wheel.pending(), 0u);
+    EXPECT_EQ(wheel.fired(), 0u);
+}
+
+// A full lane leaves due timers for the next tick instead of spinning
+TEST(TimerWheelTest, FullLaneRetriesOnNextDispatch) {
+    PoolOptions popts;
+    popts.queue_capacity_pow2 = 2;
+    LowLatencyThreadPool pool(1, popts);
+    TimerWheel wheel(pool, manual_options());
+
+    std::atomic<bool> release{false};
+    std::atomic<int> started{0};
+    struct Blocker {
+        std::atomic<bool>* release;
+        std::atomic<int>* started;
+    } blocker{&release, &started};
+    ASSERT_TRUE(pool.enqueue_raw([](void* p) noexcept {
+        auto* b = static_cast<Blocker*>(p);
+        b->started->fetch_add(1);
+        while (!b->release->load()) std::this_thread::yield();
+    }, &blocker));
+    wait_for(started, 1);
+    std::atomic<int> filler{0};
+    while (pool.enqueue_raw(&count_run, &filler)) {
+    }
+
+    std::atomic<int> runs{0};
+    for (int i = 0; i < 3; ++i)
+        TimerWheelTestAccess::insert_at(wheel, 5, &count_run, &runs);
+    TimerWheelTestAccess::advance(wheel, 5);
+    EXPECT_FALSE(TimerWheelTestAccess::dispatch(wheel));
+    EXPECT_EQ(wheel.fired(), 0u);
+    EXPECT_GE(wheel.dispatch_retries(), 1u);
+
+    release = true;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (wheel.fired() < 3 && std::chrono::steady_clock::now() < deadline) {
+        TimerWheelTestAccess::dispatch(wheel);
+        std::this_thread::yield();
+    }
+    wait_for(runs, 3);
+    EXPECT_EQ(runs.load(), 3);
+    EXPECT_EQ(wheel.fired(), 3u);
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <thread>
+
+#if defined(__linux__)
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Event count: lets consumers of a lock-free queue sleep while it is empty
+// without putting a lock on the producer side.
+//
+// A consumer that found nothing announces itself with prepare_wait(),
+// checks the queue once more and then either cancel_wait()s (something
+// arrived) or commit_wait()s (sleeps until the next notify). A producer
+// calls notify_one()/notify_all() after publishing; if nobody is waiting
+// that is a fence and a load of a line nobody writes, no RMW and no
+// syscall.
+//
+//   producer:  queue.enqueue(x);  events.notify_one();
+//   consumer:  events.await([&] { return queue.dequeue(x); });
+//
+// A wakeup is a hint, not a token: a woken consumer re-checks and may go
+// back to sleep, and notify_one() may wake a consumer other than the one
+// that will find the item.
+class EventCount
+{
+public:
+    using Key = uint32_t;
+
+    // Registers the caller as a waiter; check the condition again after this.
+    Key prepare_wait() noexcept;
+    // The condition came true after prepare_wait().
+    void cancel_wait() noexcept { waiters.fetch_sub(1, std::memory_order_relaxed); }
+    // Sleeps until a notify newer than 'key'.
+    void commit_wait(Key key) noexcept;
+    // As commit_wait(); false if 'timeout' passed first.
+    bool commit_wait_for(Key key, std::chrono::nanoseconds timeout) noexcept;
+
+    void notify_one() noexcept { notify(1); }
+    void notify_all() noexcept { notify(INT_MAX); }
+
+    // Returns once ready() returns true; polls it 'spins' times before
+    // sleeping. ready() has the side effect, e.g. a dequeue.
+    template <typename Pred>
+    void await(Pred ready, unsigned spins = 0);
+
+    // Times a notify found a waiter and went to the kernel.
+    uint64_t wakes() const noexcept { return wakeCount.load(std::memory_order_relaxed); }
+
+private:
+    void notify(int count) noexcept;
+    static void pause() noexcept;
+
+    alignas(64) std::atomic<uint32_t> epoch{0};
+    std::atomic<uint32_t> waiters{0};
+    std::atomic<uint64_t> wakeCount{0};
+};
+
+inline EventCount::Key EventCount::prepare_wait() noexcept
+{
+    waiters.fetch_add(1, std::memory_order_relaxed);
+    // Pairs with the fence in notify(): either the producer sees us in
+    // 'waiters', or our re-check sees its item.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return epoch.load(std::memory_order_acquire);
+}
+
+inline void EventCount::commit_wait(Key key) noexcept
+{
+    while (epoch.load(std::memory_order_acquire) == key)
+    {
+#if defined(__linux__)
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&epoch), FUTEX_WAIT_PRIVATE, key, nullptr, nullptr, 0);
+#elif defined(__cpp_lib_atomic_wait)
+        epoch.wait(key, std::memory_order_acquire);
+#else
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+#endif
+    }
+    waiters.fetch_sub(1, std::memory_order_relaxed);
+}
+
+inline bool EventCount::commit_wait_for(Key key, std::chrono::nanoseconds timeout) noexcept
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    bool notified = true;
+    while (epoch.load(std::memory_order_acquire) == key)
+    {
+        auto left = deadline - std::chrono::steady_clock::now();
+        if (left <= std::chrono::nanoseconds::zero())
+        {
+            notified = false;
+            break;
+        }
+#if defined(__linux__)
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(left).count();
+        timespec ts;
+        ts.tv_sec = static_cast<time_t>(ns / 1000000000);
+        ts.tv_nsec = static_cast<long>(ns % 1000000000);
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&epoch), FUTEX_WAIT_PRIVATE, key, &ts, nullptr, 0);
+#else
+        std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(left, std::chrono::microseconds(50)));
+#endif
+    }
+    waiters.fetch_sub(1, std::memory_order_relaxed);
+    return notified;
+}
+
+inline void EventCount::notify(int count) noexcept
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters.load(std::memory_order_relaxed) == 0)
+        return;
+    epoch.fetch_add(1, std::memory_order_release);
+    wakeCount.fetch_add(1, std::memory_order_relaxed);
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&epoch), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+#elif defined(__cpp_lib_atomic_wait)
+    if (count == 1)
+        epoch.notify_one();
+    else
+        epoch.notify_all();
+#else
+    (void)count;
+#endif
+}
+
+inline void EventCount::pause() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+template <typename Pred>
+void EventCount::await(Pred ready, unsigned spins)
+{
+    for (unsigned i = 0; i < spins; ++i)
+    {
+        if (ready())
+            return;
+        pause();
+    }
+    for (;;)
+    {
+        if (ready())
+            return;
+        Key key = prepare_wait();
+        if (ready())
+        {
+            cancel_wait();
+            return;
+        }
+        commit_wait(key);
+    }
+}
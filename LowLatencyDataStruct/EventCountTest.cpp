@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "EventCount.hpp"
+#include "LockFreeQueue.hpp"
+#include "MPMCBoundedQueue.hpp"
+
+// Without waiters a notify doesn't go to the kernel
+TEST(EventCountTest, NotifyWithoutWaiters) {
+    EventCount events;
+    events.notify_one();
+    events.notify_all();
+    EXPECT_EQ(events.wakes(), 0u);
+}
+
+TEST(EventCountTest, CancelWait) {
+    EventCount events;
+    events.prepare_wait();
+    events.cancel_wait();
+    events.notify_one();
+    EXPECT_EQ(events.wakes(), 0u);
+}
+
+// A notify between prepare_wait and commit_wait is not lost
+TEST(EventCountTest, NotifyBeforeCommit) {
+    EventCount events;
+    EventCount::Key key = events.prepare_wait();
+    events.notify_one();
+    events.commit_wait(key);
+    EXPECT_EQ(events.wakes(), 1u);
+}
+
+TEST(EventCountTest, CommitWaitForTimesOut) {
+    EventCount events;
+    EventCount::Key key = events.prepare_wait();
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(events.commit_wait_for(key, std::chrono::milliseconds(5)));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(5));
+
+    // The waiter is gone again
+    events.notify_one();
+    EXPECT_EQ(events.wakes(), 0u);
+}
+
+// A sleeping LockFreeQueue consumer picks up items that arrive slowly
+TEST(EventCountTest, BlockingLockFreeQueueConsumer) {
+    constexpr int count = 50;
+    LockFreeQueue<int> queue(8);
+    EventCount events;
+
+    std::thread producer([&]() {
+        for (int i = 0; i < count; ++i) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            while (!queue.enqueue(i)) {
+                // Retry until the item is enqueued
+                std::this_thread::yield();
+            }
+            events.notify_one();
+        }
+    });
+
+    int item;
+    for (int i = 0; i < count; ++i) {
+        events.await([&] { return queue.dequeue(item); });
+        ASSERT_EQ(item, i);
+    }
+    producer.join();
+    EXPECT_GT(events.wakes(), 0u);
+}
+
+// Two producers, two sleeping consumers: every item arrives exactly once
+TEST(EventCountTest, ProducersConsumersParallel) {
+    constexpr int count = 20000;
+    MPMCBoundedQueue<int> queue(64);
+    EventCount events;
+    std::vector<std::atomic<int>> seen(2 * count);
+    std::vector<std::thread> threads;
+
+    for (int p = 0; p < 2; ++p) {
+        threads.emplace_back([&, p]() {
+            for (int i = 0; i < count; ++i) {
+                while (!queue.enqueue(p * count + i)) {
+                    // Retry until the item is enqueued
+                    std::this_thread::yield();
+                }
+                events.notify_one();
+            }
+        });
+    }
+    for (int c = 0; c < 2; ++c) {
+        threads.emplace_back([&]() {
+            int item;
+            // Each consumer takes half of the items
+            for (int i = 0; i < count; ++i) {
+                events.await([&] { return queue.dequeue(item); }, 64);
+                seen[item].fetch_add(1);
+            }
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    for (auto& s : seen)
+        ASSERT_EQ(s.load(), 1);
+}
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "LockFreeQueue.hpp"
+
+// Many producers, one consumer, without any atomic shared between
+// producers: every producer registers and gets a LockFreeQueue (SPSC) lane
+// of its own, and the consumer polls the lanes.
+//
+// Polling:
+//   RoundRobin - the consumer tries the lanes in turn, one item per lane
+//                per turn. Producers write nothing but their own lane.
+//   Bitmap     - a producer whose lane was empty sets the lane's bit in a
+//                shared bitmap, so the consumer skips idle lanes. The bit
+//                is set once per empty->busy transition, not per item, at
+//                the price of a fence per enqueue.
+//
+// dequeue_merged() rebuilds a global order: each lane is taken to be
+// ordered by 'key' already (e.g. a feed's own timestamps) and the consumer
+// hands out the smallest head among the lanes. Lanes that are empty at the
+// time of the call can't take part, so the order is only global across
+// items already enqueued.
+//
+// T has the requirements of LockFreeQueue. Each lane holds laneCapacity - 1
+// items.
+
+enum class FanInPolling
+{
+    RoundRobin,
+    Bitmap
+};
+
+template <typename T>
+class FanInQueue
+{
+    struct Lane;
+
+public:
+    // A registered producer's handle to its lane. Only one thread may use a
+    // handle at a time; the lane is given back when the handle is destroyed
+    // (items still in it are delivered as usual).
+    class Producer
+    {
+    public:
+        Producer(Producer &&other) noexcept : owner(other.owner), lane(std::exchange(other.lane, nullptr)) {}
+        Producer &operator=(Producer &&) = delete;
+        ~Producer();
+
+        // False if the lane is full.
+        bool enqueue(const T &item) noexcept;
+        bool enqueue(T &&item) noexcept;
+
+        size_t lane_index() const noexcept { return lane->index; }
+
+    private:
+        friend class FanInQueue;
+        Producer(FanInQueue *owner, Lane *lane) : owner(owner), lane(lane) {}
+
+        FanInQueue *owner;
+        Lane *lane;
+    };
+
+    // 'laneCapacity' is rounded up to a power of two.
+    FanInQueue(size_t maxProducers, size_t laneCapacity, FanInPolling polling = FanInPolling::RoundRobin);
+
+    FanInQueue(const FanInQueue<T> &) = delete;
+    FanInQueue &operator=(const FanInQueue<T> &) = delete;
+
+    // Any thread. Throws std::length_error if every lane is taken.
+    Producer registerProducer();
+
+    // Consumer only. False if no lane had an item.
+    bool dequeue(T &item);
+
+    // Consumer only. Up to 'max' items, taken round-robin across lanes;
+    // returns how many.
+    size_t dequeue_bulk(T *out, size_t max);
+
+    // Consumer only. The item with the smallest key(item) among the lane
+    // heads; 'key' must be the order each lane is already in.
+    template <typename Key>
+    bool dequeue_merged(T &item, Key key);
+
+    size_t lanes() const noexcept { return laneList.size(); }
+
+private:
+    struct alignas(64) Lane
+    {
+        Lane(size_t index, size_t capacity) : queue(capacity), index(index) {}
+
+        LockFreeQueue<T> queue;
+        const size_t index;
+        std::atomic<bool> owned{false};
+        alignas(64) std::atomic<bool> signalled{false}; // Bitmap: this lane's bit is (being) set
+        std::optional<T> staged;                        // consumer only: head held back by dequeue_merged
+    };
+
+    static size_t roundUpPow2(size_t x)
+    {
+        size_t n = 2;
+        while (n < x)
+            n <<= 1;
+        return n;
+    }
+
+    void signal(Lane &lane) noexcept;
+    bool pollLane(size_t i, T &item);
+    // Lanes worth polling: bits set by producers, or a staged head.
+    uint64_t candidates(size_t word) const noexcept;
+
+    const FanInPolling polling;
+    std::vector<std::unique_ptr<Lane>> laneList;
+    std::unique_ptr<std::atomic<uint64_t>[]> bits; // Bitmap polling
+    std::vector<uint64_t> stagedBits;              // consumer only
+    size_t words;
+    size_t next = 0; // consumer only: where the next round-robin turn starts
+};
+
+template <typename T>
+FanInQueue<T>::FanInQueue(size_t maxProducers, size_t laneCapacity, FanInPolling polling)
+    : polling(polling), words((maxProducers + 63) / 64)
+{
+    laneList.reserve(maxProducers);
+    for (size_t i = 0; i < maxProducers; ++i)
+        laneList.emplace_back(new Lane(i, roundUpPow2(laneCapacity)));
+    bits.reset(new std::atomic<uint64_t>[words]);
+    for (size_t w = 0; w < words; ++w)
+        bits[w].store(0, std::memory_order_relaxed);
+    stagedBits.assign(words, 0);
+}
+
+template <typename T>
+typename FanInQueue<T>::Producer FanInQueue<T>::registerProducer()
+{
+    for (auto &lane : laneList)
+    {
+        bool expected = false;
+        if (!lane->owned.load(std::memory_order_relaxed) &&
+            lane->owned.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            return Producer(this, lane.get());
+    }
+    throw std::length_error("FanInQueue: all lanes taken");
+}
+
+template <typename T>
+FanInQueue<T>::Producer::~Producer()
+{
+    if (lane)
+        lane->owned.store(false, std::memory_order_release);
+}
+
+template <typename T>
+bool FanInQueue<T>::Producer::enqueue(const T &item) noexcept
+{
+    if (!lane->queue.enqueue(item))
+        return false;
+    owner->signal(*lane);
+    return true;
+}
+
+template <typename T>
+bool FanInQueue<T>::Producer::enqueue(T &&item) noexcept
+{
+    if (!lane->queue.enqueue(std::move(item)))
+        return false;
+    owner->signal(*lane);
+    return true;
+}
+
+template <typename T>
+void FanInQueue<T>::signal(Lane &lane) noexcept
+{
+    if (polling != FanInPolling::Bitmap)
+        return;
+    // Pairs with the fence in pollLane(): either we see the consumer's
+    // 'signalled = false' and set the bit again, or its re-check sees our
+    // item.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!lane.signalled.load(std::memory_order_relaxed) && !lane.signalled.exchange(true, std::memory_order_acq_rel))
+        bits[lane.index / 64].fetch_or(uint64_t(1) << (lane.index % 64), std::memory_order_release);
+}
+
+template <typename T>
+bool FanInQueue<T>::pollLane(size_t i, T &item)
+{
+    Lane &lane = *laneList[i];
+    if (lane.staged)
+    {
+        item = std::move(*lane.staged);
+        lane.staged.reset();
+        stagedBits[i / 64] &= ~(uint64_t(1) << (i % 64));
+        return true;
+    }
+    if (lane.queue.dequeue(item))
+        return true;
+    if (polling == FanInPolling::Bitmap && lane.signalled.load(std::memory_order_relaxed))
+    {
+        // Looks idle: drop the bit before 'signalled', so a producer that
+        // sees 'signalled' false sets the bit after we cleared it.
+        uint64_t bit = uint64_t(1) << (i % 64);
+        bits[i / 64].fetch_and(~bit, std::memory_order_relaxed);
+        lane.signalled.store(false, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (lane.queue.dequeue(item))
+        {
+            // Raced with an enqueue that may not have re-signalled.
+            lane.signalled.store(true, std::memory_order_relaxed);
+            bits[i / 64].fetch_or(bit, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename T>
+uint64_t FanInQueue<T>::candidates(size_t word) const noexcept
+{
+    if (polling != FanInPolling::Bitmap)
+        return ~uint64_t(0);
+    return bits[word].load(std::memory_order_acquire) | stagedBits[word];
+}
+
+template <typename T>
+bool FanInQueue<T>::dequeue(T &item)
+{
+    size_t n = laneList.size();
+    for (size_t k = 0; k < n; ++k)
+    {
+        size_t i = next + k < n ? next + k : next + k - n;
+        if (polling == FanInPolling::Bitmap && !(candidates(i / 64) >> (i % 64) & 1))
+            continue;
+        if (pollLane(i, item))
+        {
+            next = i + 1 < n ? i + 1 : 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename T>
+size_t FanInQueue<T>::dequeue_bulk(T *out, size_t max)
+{
+    size_t taken = 0;
+    while (taken < max && dequeue(out[taken]))
+        ++taken;
+    return taken;
+}
+
+template <typename T>
+template <typename Key>
+bool FanInQueue<T>::dequeue_merged(T &item, Key key)
+{
+    Lane *best = nullptr;
+    for (size_t i = 0; i < laneList.size(); ++i)
+    {
+        Lane &lane = *laneList[i];
+        if (!lane.staged)
+        {
+            if (polling == FanInPolling::Bitmap && !(candidates(i / 64) >> (i % 64) & 1))
+                continue;
+            T head;
+            if (!pollLane(i, head))
+                continue;
+            lane.staged.emplace(std::move(head));
+            stagedBits[i / 64] |= uint64_t(1) << (i % 64);
+        }
+        if (!best || key(*lane.staged) < key(*best->staged))
+            best = &lane;
+    }
+    if (!best)
+        return false;
+    return pollLane(best->index, item);
+}
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "FanInQueue.hpp"
+
+constexpr size_t lane_capacity = 4;
+
+class FanInQueueTest : public ::testing::TestWithParam<FanInPolling> {
+protected:
+    FanInQueueTest() : queue(3, lane_capacity, GetParam()) {}
+
+    FanInQueue<std::string> queue;
+};
+
+INSTANTIATE_TEST_SUITE_P(Polling, FanInQueueTest,
+                         ::testing::Values(FanInPolling::RoundRobin, FanInPolling::Bitmap));
+
+// Every producer gets a lane of its own until they run out
+TEST_P(FanInQueueTest, Register) {
+    auto a = queue.registerProducer();
+    auto b = queue.registerProducer();
+    auto c = queue.registerProducer();
+    EXPECT_NE(a.lane_index(), b.lane_index());
+    EXPECT_NE(b.lane_index(), c.lane_index());
+    EXPECT_THROW(queue.registerProducer(), std::length_error);
+}
+
+// A released lane can be registered again; its items are still delivered
+TEST_P(FanInQueueTest, ReleaseLane) {
+    std::string item;
+    {
+        auto a = queue.registerProducer();
+        auto b = queue.registerProducer();
+        auto c = queue.registerProducer();
+        EXPECT_TRUE(c.enqueue("left behind"));
+    }
+    auto d = queue.registerProducer();
+    EXPECT_TRUE(queue.dequeue(item));
+    EXPECT_EQ(item, std::string("left behind"));
+    EXPECT_FALSE(queue.dequeue(item));
+}
+
+// Each lane is an SPSC LockFreeQueue and fills up on its own
+TEST_P(FanInQueueTest, LaneFull) {
+    auto a = queue.registerProducer();
+    auto b = queue.registerProducer();
+    EXPECT_TRUE(a.enqueue("1"));
+    EXPECT_TRUE(a.enqueue("2"));
+    EXPECT_TRUE(a.enqueue("3"));
+    EXPECT_FALSE(a.enqueue("4"));
+    EXPECT_TRUE(b.enqueue("x"));
+}
+
+// The consumer takes one item per lane per turn
+TEST_P(FanInQueueTest, RoundRobin) {
+    auto a = queue.registerProducer();
+    auto b = queue.registerProducer();
+    a.enqueue("a1");
+    a.enqueue("a2");
+    a.enqueue("a3");
+    b.enqueue("b1");
+
+    std::string out[8];
+    EXPECT_EQ(queue.dequeue_bulk(out, 8), 4u);
+    EXPECT_EQ(out[0], std::string("a1"));
+    EXPECT_EQ(out[1], std::string("b1"));
+    EXPECT_EQ(out[2], std::string("a2"));
+    EXPECT_EQ(out[3], std::string("a3"));
+    EXPECT_FALSE(queue.dequeue(out[0]));
+}
+
+// Lanes ordered by their own timestamps merge into one ordered stream
+TEST_P(FanInQueueTest, Merged) {
+    FanInQueue<std::pair<int, int>> feeds(3, 8, GetParam());
+    auto a = feeds.registerProducer();
+    auto b = feeds.registerProducer();
+    auto c = feeds.registerProducer();
+    for (int t : {1, 4, 7})
+        a.enqueue({t, 0});
+    for (int t : {2, 3, 9})
+        b.enqueue({t, 1});
+    for (int t : {5, 6, 8})
+        c.enqueue({t, 2});
+
+    auto timestamp = [](const std::pair<int, int>& e) { return e.first; };
+    std::pair<int, int> item;
+    for (int t = 1; t <= 9; ++t) {
+        ASSERT_TRUE(feeds.dequeue_merged(item, timestamp));
+        EXPECT_EQ(item.first, t);
+    }
+    EXPECT_FALSE(feeds.dequeue_merged(item, timestamp));
+    EXPECT_FALSE(feeds.dequeue(item));
+}
+
+// Heads held back by dequeue_merged are still handed out by dequeue
+TEST_P(FanInQueueTest, MergedThenPlain) {
+    FanInQueue<int> feeds(2, 8, GetParam());
+    auto a = feeds.registerProducer();
+    auto b = feeds.registerProducer();
+    a.enqueue(1);
+    a.enqueue(3);
+    b.enqueue(2);
+
+    int item;
+    auto identity = [](int v) { return v; };
+    EXPECT_TRUE(feeds.dequeue_merged(item, identity));
+    EXPECT_EQ(item, 1);
+    std::vector<int> rest;
+    while (feeds.dequeue(item))
+        rest.push_back(item);
+    std::sort(rest.begin(), rest.end());
+    EXPECT_EQ(rest, (std::vector<int>{2, 3}));
+}
+
+// Several producers, one consumer: every item arrives exactly once and each
+// producer's items in the order they were sent
+TEST_P(FanInQueueTest, ProducersParallel) {
+    constexpr int producers = 4;
+    constexpr int count = 20000;
+    FanInQueue<int> feeds(producers, 64, GetParam());
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p]() {
+            auto lane = feeds.registerProducer();
+            for (int i = 0; i < count; ++i) {
+                while (!lane.enqueue(p * count + i)) {
+                    // Retry until the item is enqueued
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<int> seen(producers * count, 0);
+    std::vector<int> last(producers, -1);
+    bool ordered = true;
+    int received = 0;
+    int batch[16];
+    while (received < producers * count) {
+        size_t n = feeds.dequeue_bulk(batch, 16);
+        if (n == 0)
+            std::this_thread::yield();
+        for (size_t i = 0; i < n; ++i) {
+            int id = batch[i];
+            if (id % count <= last[id / count])
+                ordered = false;
+            last[id / count] = id % count;
+            ++seen[id];
+        }
+        received += static_cast<int>(n);
+    }
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT_TRUE(ordered);
+    for (int s : seen)
+        ASSERT_EQ(s, 1);
+}
@@ -0,0 +1,304 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// Hazard pointers and node recycling for the lock-free containers.
+//
+// A thread that is about to dereference a shared node first publishes it in
+// one of its hazard slots (HazardPointer::protect). A node unlinked from a
+// container is retire()d instead of freed; once a thread has collected
+// enough retired nodes it scans every published hazard and hands the nodes
+// nobody protects to their reclaim function. A protected node therefore can
+// neither be freed nor reused under a reader, which also rules out ABA on
+// the container's CAS.
+//
+// Reclaimed nodes go back to a NodePool rather than to the allocator, so a
+// warmed-up container doesn't allocate. There is one pool per node type,
+// shared by all containers of that type; it keeps its high-water mark.
+
+constexpr size_t hazardSlotsPerThread = 4;
+
+struct HazardRecord
+{
+    struct Retired
+    {
+        void *ptr;
+        void (*reclaim)(void *);
+    };
+
+    std::atomic<void *> hazards[hazardSlotsPerThread] = {};
+    std::atomic<bool> active{false};
+    HazardRecord *next = nullptr;   // records are never unlinked
+    std::vector<Retired> retired;   // only touched by the owning thread
+    std::vector<void *> scratch;    // scan() buffer, owner only
+};
+
+class HazardDomain
+{
+public:
+    static HazardDomain &instance();
+
+    // Claims a free record, adding one if every record is in use.
+    HazardRecord *acquire();
+    // Clears the record's hazards and gives it up; its retired nodes stay
+    // with it for the next owner to reclaim.
+    void release(HazardRecord *rec);
+    void retire(HazardRecord *rec, void *ptr, void (*reclaim)(void *));
+    // Reclaims every retired node of 'rec' that no thread protects.
+    void scan(HazardRecord *rec);
+
+    size_t records() const { return recordCount.load(std::memory_order_relaxed); }
+
+    HazardDomain() = default;
+    HazardDomain(const HazardDomain &) = delete;
+    // Runs at exit: retired nodes belong to pools that may already be gone,
+    // so they are not reclaimed.
+    ~HazardDomain();
+
+private:
+    std::atomic<HazardRecord *> head{nullptr};
+    std::atomic<size_t> recordCount{0};
+};
+
+// The calling thread's record; released when the thread exits.
+HazardRecord &hazardRecord();
+
+// RAII owner of one of the calling thread's hazard slots. Slots are per
+// thread, so one operation must not use the same slot for two nodes.
+class HazardPointer
+{
+public:
+    explicit HazardPointer(unsigned index = 0);
+    ~HazardPointer() { clear(); }
+    HazardPointer(const HazardPointer &) = delete;
+    HazardPointer &operator=(const HazardPointer &) = delete;
+
+    // Loads 'src' and publishes it until the published value is still the
+    // current one, so the returned node is safe to dereference.
+    template <typename T>
+    T *protect(const std::atomic<T *> &src) noexcept;
+
+    void clear() noexcept { slot.store(nullptr, std::memory_order_release); }
+
+private:
+    std::atomic<void *> &slot;
+};
+
+template <typename T>
+void retire(T *ptr, void (*reclaim)(void *))
+{
+    HazardDomain::instance().retire(&hazardRecord(), ptr, reclaim);
+}
+
+// Lock-free free list of raw node storage. The head carries a 16-bit tag
+// next to the 48-bit block address, so a pop that raced with a pop/push of
+// the same block fails its CAS.
+template <typename T>
+class NodePool
+{
+public:
+    static NodePool &instance();
+
+    // Storage for one T; construct it with placement new.
+    void *allocate();
+    // Takes back storage from allocate(); the T must already be destroyed.
+    void deallocate(void *p) noexcept;
+
+    NodePool() = default;
+    NodePool(const NodePool &) = delete;
+    ~NodePool();
+
+private:
+    struct Block
+    {
+        alignas(T) unsigned char storage[sizeof(T)];
+        std::atomic<Block *> next{nullptr};
+    };
+
+    static constexpr size_t chunkSize = 64;
+    static constexpr uint64_t addressMask = (uint64_t(1) << 48) - 1;
+
+    void pushChain(Block *first, Block *last) noexcept;
+
+    std::atomic<uint64_t> top{0};
+    std::mutex chunkMutex;
+    std::vector<Block *> chunks;
+};
+
+inline HazardDomain &HazardDomain::instance()
+{
+    static HazardDomain domain;
+    return domain;
+}
+
+inline HazardRecord *HazardDomain::acquire()
+{
+    for (HazardRecord *rec = head.load(std::memory_order_acquire); rec; rec = rec->next)
+    {
+        bool expected = false;
+        if (!rec->active.load(std::memory_order_relaxed) &&
+            rec->active.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            return rec;
+    }
+    HazardRecord *rec = new HazardRecord;
+    rec->active.store(true, std::memory_order_relaxed);
+    rec->next = head.load(std::memory_order_relaxed);
+    while (!head.compare_exchange_weak(rec->next, rec, std::memory_order_release,
+                                       std::memory_order_relaxed))
+        ;
+    recordCount.fetch_add(1, std::memory_order_relaxed);
+    return rec;
+}
+
+inline void HazardDomain::release(HazardRecord *rec)
+{
+    for (auto &h : rec->hazards)
+        h.store(nullptr, std::memory_order_release);
+    scan(rec);
+    rec->active.store(false, std::memory_order_release);
+}
+
+inline void HazardDomain::retire(HazardRecord *rec, void *ptr, void (*reclaim)(void *))
+{
+    rec->retired.push_back({ptr, reclaim});
+    // Scanning costs O(hazards), so amortise it over that many retirements.
+    size_t threshold = std::max<size_t>(64, 2 * hazardSlotsPerThread * records());
+    if (rec->retired.size() >= threshold)
+        scan(rec);
+}
+
+inline void HazardDomain::scan(HazardRecord *rec)
+{
+    // Pairs with the fence in protect(): a reader either published its
+    // hazard before we look, or sees the node already unlinked and retries.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::vector<void *> &protectedPtrs = rec->scratch;
+    protectedPtrs.clear();
+    for (HazardRecord *r = head.load(std::memory_order_acquire); r; r = r->next)
+        for (auto &h : r->hazards)
+            if (void *p = h.load(std::memory_order_acquire))
+                protectedPtrs.push_back(p);
+    std::sort(protectedPtrs.begin(), protectedPtrs.end());
+
+    auto reclaimable = std::partition(rec->retired.begin(), rec->retired.end(),
+                               [&protectedPtrs](const HazardRecord::Retired &r)
+                               { return std::binary_search(protectedPtrs.begin(), protectedPtrs.end(), r.ptr); });
+    for (auto it = reclaimable; it != rec->retired.end(); ++it)
+        it->reclaim(it->ptr);
+    rec->retired.erase(reclaimable, rec->retired.end());
+}
+
+inline HazardDomain::~HazardDomain()
+{
+    HazardRecord *rec = head.load(std::memory_order_relaxed);
+    while (rec)
+    {
+        HazardRecord *next = rec->next;
+        delete rec;
+        rec = next;
+    }
+}
+
+inline HazardRecord &hazardRecord()
+{
+    struct Holder
+    {
+        HazardRecord *rec = HazardDomain::instance().acquire();
+        ~Holder() { HazardDomain::instance().release(rec); }
+    };
+    thread_local Holder holder;
+    return *holder.rec;
+}
+
+inline HazardPointer::HazardPointer(unsigned index) : slot(hazardRecord().hazards[index])
+{
+    assert(index < hazardSlotsPerThread);
+}
+
+template <typename T>
+T *HazardPointer::protect(const std::atomic<T *> &src) noexcept
+{
+    T *p = src.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        slot.store(p, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        T *q = src.load(std::memory_order_acquire);
+        if (q == p)
+            return p;
+        p = q;
+    }
+}
+
+template <typename T>
+NodePool<T> &NodePool<T>::instance()
+{
+    static NodePool pool;
+    return pool;
+}
+
+template <typename T>
+void *NodePool<T>::allocate()
+{
+    uint64_t old = top.load(std::memory_order_acquire);
+    for (;;)
+    {
+        Block *b = reinterpret_cast<Block *>(old & addressMask);
+        if (!b)
+            break;
+        // 'b' may be popped and reused under us; its next is then stale,
+        // but the tag has moved and the CAS fails.
+        Block *next = b->next.load(std::memory_order_relaxed);
+        uint64_t tagged = (old & ~addressMask) + (uint64_t(1) << 48);
+        if (top.compare_exchange_weak(old, tagged | reinterpret_cast<uint64_t>(next),
+                                      std::memory_order_acquire, std::memory_order_acquire))
+            return b->storage;
+    }
+
+    Block *chunk = new Block[chunkSize];
+    assert((reinterpret_cast<uint64_t>(chunk + chunkSize) & ~addressMask) == 0);
+    {
+        std::lock_guard<std::mutex> lock(chunkMutex);
+        chunks.push_back(chunk);
+    }
+    for (size_t i = 1; i + 1 < chunkSize; ++i)
+        chunk[i].next.store(&chunk[i + 1], std::memory_order_relaxed);
+    pushChain(&chunk[1], &chunk[chunkSize - 1]);
+    return chunk[0].storage;
+}
+
+template <typename T>
+void NodePool<T>::deallocate(void *p) noexcept
+{
+    // storage is the first member, so the block starts at p.
+    Block *b = reinterpret_cast<Block *>(p);
+    pushChain(b, b);
+}
+
+template <typename T>
+void NodePool<T>::pushChain(Block *first, Block *last) noexcept
+{
+    uint64_t old = top.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        last->next.store(reinterpret_cast<Block *>(old & addressMask), std::memory_order_relaxed);
+        uint64_t tagged = (old & ~addressMask) + (uint64_t(1) << 48);
+        if (top.compare_exchange_weak(old, tagged | reinterpret_cast<uint64_t>(first),
+                                      std::memory_order_release, std::memory_order_relaxed))
+            return;
+    }
+}
+
+template <typename T>
+NodePool<T>::~NodePool()
+{
+    for (Block *chunk : chunks)
+        delete[] chunk;
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "HazardPointer.hpp"
+
+namespace {
+
+std::atomic<int> reclaimed{0};
+
+struct Tracked {
+    int value = 0;
+};
+
+void reclaimTracked(void* p) {
+    NodePool<Tracked>::instance().deallocate(p);
+    reclaimed.fetch_add(1);
+}
+
+Tracked* makeTracked(int value) {
+    return new (NodePool<Tracked>::instance().allocate()) Tracked{value};
+}
+
+} // namespace
+
+// A protected node survives scans; once unprotected it is reclaimed.
+TEST(HazardPointerTest, ProtectedNodeIsNotReclaimed) {
+    reclaimed = 0;
+    std::atomic<Tracked*> shared{makeTracked(1)};
+    HazardPointer hp;
+    Tracked* p = hp.protect(shared);
+    ASSERT_EQ(p, shared.load());
+
+    shared.store(nullptr);
+    retire(p, &reclaimTracked);
+    HazardDomain::instance().scan(&hazardRecord());
+    EXPECT_EQ(reclaimed.load(), 0);
+    EXPECT_EQ(p->value, 1);
+
+    hp.clear();
+    HazardDomain::instance().scan(&hazardRecord());
+    EXPECT_EQ(reclaimed.load(), 1);
+}
+
+// A hazard published by another thread also blocks reclamation.
+TEST(HazardPointerTest, OtherThreadsHazard) {
+    reclaimed = 0;
+    std::atomic<Tracked*> shared{makeTracked(2)};
+    std::atomic<bool> published{false}, done{false};
+    std::thread reader([&]() {
+        HazardPointer hp;
+        Tracked* p = hp.protect(shared);
+        published = true;
+        while (!done)
+            std::this_thread::yield();
+        EXPECT_EQ(p->value, 2);
+    });
+    while (!published)
+        std::this_thread::yield();
+
+    Tracked* p = shared.exchange(nullptr);
+    retire(p, &reclaimTracked);
+    HazardDomain::instance().scan(&hazardRecord());
+    EXPECT_EQ(reclaimed.load(), 0);
+
+    done = true;
+    reader.join();
+    HazardDomain::instance().scan(&hazardRecord());
+    EXPECT_EQ(reclaimed.load(), 1);
+}
+
+// Records of exited threads are reused rather than leaked.
+TEST(HazardPointerTest, RecordsAreReused) {
+    for (int i = 0; i < 4; ++i)
+        std::thread([]() { hazardRecord(); }).join();
+    size_t records = HazardDomain::instance().records();
+    for (int i = 0; i < 16; ++i)
+        std::thread([]() { hazardRecord(); }).join();
+    EXPECT_EQ(HazardDomain::instance().records(), records);
+}
+
+// Reclaimed storage is handed out again by the pool.
+TEST(NodePoolTest, RecyclesStorage) {
+    auto& pool = NodePool<Tracked>::instance();
+    void* a = pool.allocate();
+    pool.deallocate(a);
+    void* b = pool.allocate();
+    EXPECT_EQ(a, b);
+    pool.deallocate(b);
+}
@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "LockFreeStack.hpp"
+#include "MPSCQueue.hpp"
+#include "UnboundedMPMCQueue.hpp"
+#include "UnboundedSPSCQueue.hpp"
+
+// What every container here owes its values, whatever its algorithm: move-only
+// values, destruction of what is left at the end, and exactly-once delivery
+// with as many producers and consumers as the container allows. What can go
+// wrong in a particular algorithm is tested next to it.
+
+struct MPMCQueueOps {
+    template <typename T>
+    using Container = UnboundedMPMCQueue<T>;
+    static constexpr int producers = 3;
+    static constexpr int consumers = 3;
+    static constexpr bool fifo = true;
+    static constexpr bool moveOnlyValues = true;
+
+    template <typename T>
+    static std::unique_ptr<Container<T>> make() { return std::make_unique<Container<T>>(); }
+    template <typename T>
+    static bool push(Container<T>& c, T&& v) { c.enqueue(std::move(v)); return true; }
+    template <typename T>
+    static bool pop(Container<T>& c, T& v) { return c.dequeue(v); }
+};
+
+struct StackOps {
+    template <typename T>
+    using Container = LockFreeStack<T>;
+    static constexpr int producers = 2;
+    static constexpr int consumers = 2;
+    static constexpr bool fifo = false;
+    static constexpr bool moveOnlyValues = true;
+
+    template <typename T>
+    static std::unique_ptr<Container<T>> make() { return std::make_unique<Container<T>>(); }
+    template <typename T>
+    static bool push(Container<T>& c, T&& v) { c.push(std::move(v)); return true; }
+    template <typename T>
+    static bool pop(Container<T>& c, T& v) {
+        auto item = c.try_pop();
+        if (!item)
+            return false;
+        v = std::move(*item);
+        return true;
+    }
+};
+
+struct BoundedMPSCQueueOps {
+    template <typename T>
+    using Container = BoundedMPSCQueue<T>;
+    static constexpr int producers = 4;
+    static constexpr int consumers = 1;
+    static constexpr bool fifo = true;
+    static constexpr bool moveOnlyValues = true;
+
+    template <typename T>
+    static std::unique_ptr<Container<T>> make() { return std::make_unique<Container<T>>(64); }
+    template <typename T>
+    static bool push(Container<T>& c, T&& v) { return c.enqueue(std::move(v)); }
+    template <typename T>
+    static bool pop(Container<T>& c, T& v) { return c.dequeue(v); }
+};
+
+struct SPSCQueueOps {
+    template <typename T>
+    using Container = UnboundedSPSCQueue<T>;
+    static constexpr int producers = 1;
+    static constexpr int consumers = 1;
+    static constexpr bool fifo = true;
+    static constexpr bool moveOnlyValues = false; // LockFreeQueue copies
+
+    template <typename T>
+    static std::unique_ptr<Container<T>> make() { return std::make_unique<Container<T>>(64, 4); }
+    template <typename T>
+    static bool push(Container<T>& c, T&& v) { c.enqueue(std::move(v)); return true; }
+    template <typename T>
+    static bool pop(Container<T>& c, T& v) { return c.dequeue(v); }
+};
+
+template <typename Ops>
+class LockFreeContainersTest : public ::testing::Test {
+};
+
+using Containers = ::testing::Types<MPMCQueueOps, StackOps, BoundedMPSCQueueOps, SPSCQueueOps>;
+TYPED_TEST_SUITE(LockFreeContainersTest, Containers);
+
+TYPED_TEST(LockFreeContainersTest, MoveOnly) {
+    using Ops = TypeParam;
+    if constexpr (Ops::moveOnlyValues) {
+        auto c = Ops::template make<std::unique_ptr<int>>();
+        EXPECT_TRUE(Ops::push(*c, std::make_unique<int>(7)));
+        std::unique_ptr<int> item;
+        EXPECT_TRUE(Ops::pop(*c, item));
+        EXPECT_EQ(*item, 7);
+        EXPECT_FALSE(Ops::pop(*c, item));
+    } else {
+        GTEST_SKIP() << "values must be copyable";
+    }
+}
+
+// Values still held are destroyed with the container, popped ones are not
+// destroyed twice
+TYPED_TEST(LockFreeContainersTest, DestroysRemaining) {
+    using Ops = TypeParam;
+    auto counter = std::make_shared<int>(0);
+    {
+        auto c = Ops::template make<std::shared_ptr<int>>();
+        for (int i = 0; i < 5; ++i)
+            EXPECT_TRUE(Ops::push(*c, std::shared_ptr<int>(counter)));
+        std::shared_ptr<int> item;
+        EXPECT_TRUE(Ops::pop(*c, item));
+        item.reset();
+        EXPECT_EQ(counter.use_count(), 5);
+    }
+    EXPECT_EQ(counter.use_count(), 1);
+}
+
+// As many producers and consumers as the container allows: every item is
+// taken exactly once and, from a FIFO, each consumer sees any one
+// producer's items in the order they were sent
+TYPED_TEST(LockFreeContainersTest, ProducersConsumersParallel) {
+    using Ops = TypeParam;
+    constexpr int producers = Ops::producers;
+    constexpr int consumers = Ops::consumers;
+    constexpr int count = 20000;
+    auto c = Ops::template make<int>();
+    std::vector<std::atomic<int>> seen(producers * count);
+    std::atomic<int> taken{0};
+    std::atomic<bool> ordered{true};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p]() {
+            for (int i = 0; i < count; ++i) {
+                while (!Ops::push(*c, p * count + i)) {
+                    // Retry until the item is accepted
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int k = 0; k < consumers; ++k) {
+        threads.emplace_back([&]() {
+            std::vector<int> last(producers, -1);
+            int item;
+            while (taken.load() < producers * count) {
+                if (!Ops::pop(*c, item)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                taken.fetch_add(1);
+                if (Ops::fifo && item % count <= last[item / count])
+                    ordered = false;
+                last[item / count] = item % count;
+                seen[item].fetch_add(1);
+            }
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT_TRUE(ordered.load());
+    for (auto& s : seen)
+        ASSERT_EQ(s.load(), 1);
+    int item;
+    EXPECT_FALSE(Ops::pop(*c, item));
+}
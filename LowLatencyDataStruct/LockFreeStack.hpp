@@ -0,0 +1,214 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "HazardPointer.hpp"
+
+// Treiber stack: push and pop are a single CAS on the head. Nodes come from
+// NodePool and popped nodes are retired through hazard pointers, so a pop
+// never touches freed memory and can't be fooled by ABA.
+//
+// With eliminationSlots > 0, a push or pop whose CAS loses a race tries a
+// random slot of an elimination array instead: a pusher parks its node
+// there for a moment and a popper that finds it takes it directly, so the
+// pair completes without touching the head at all. This only pays off
+// under heavy contention; leave it at 0 otherwise.
+template <typename T>
+class LockFreeStack
+{
+public:
+    explicit LockFreeStack(size_t eliminationSlots = 0);
+    ~LockFreeStack();
+
+    LockFreeStack(const LockFreeStack<T> &) = delete;
+    LockFreeStack &operator=(const LockFreeStack<T> &) = delete;
+
+    void push(const T &item) { emplace(item); }
+    void push(T &&item) { emplace(std::move(item)); }
+
+    template <typename... Args>
+    void emplace(Args &&...args);
+
+    // Empty optional if the stack is empty.
+    std::optional<T> try_pop();
+
+    bool empty() const noexcept { return head.load(std::memory_order_acquire) == nullptr; }
+
+private:
+    struct Node
+    {
+        Node *next = nullptr;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T *value() noexcept { return std::launder(reinterpret_cast<T *>(storage)); }
+    };
+
+    struct alignas(64) EliminationSlot
+    {
+        std::atomic<Node *> offer{nullptr};
+    };
+
+    static constexpr int eliminationSpins = 64;
+
+    static void reclaim(void *p) { NodePool<Node>::instance().deallocate(p); }
+    static std::optional<T> take(Node *node);
+    static void pause() noexcept;
+
+    bool eliminatePush(Node *node) noexcept;
+    Node *eliminatePop() noexcept;
+    EliminationSlot &randomSlot() noexcept;
+
+    alignas(64) std::atomic<Node *> head{nullptr};
+    std::unique_ptr<EliminationSlot[]> elimination;
+    size_t eliminationSize;
+};
+
+template <typename T>
+LockFreeStack<T>::LockFreeStack(size_t eliminationSlots)
+    : elimination(eliminationSlots ? new EliminationSlot[eliminationSlots] : nullptr),
+      eliminationSize(eliminationSlots)
+{
+}
+
+template <typename T>
+LockFreeStack<T>::~LockFreeStack()
+{
+    Node *node = head.load(std::memory_order_relaxed);
+    while (node)
+    {
+        Node *next = node->next;
+        take(node);
+        node = next;
+    }
+}
+
+template <typename T>
+template <typename... Args>
+void LockFreeStack<T>::emplace(Args &&...args)
+{
+    void *mem = NodePool<Node>::instance().allocate();
+    Node *node = new (mem) Node;
+    try
+    {
+        new (node->storage) T(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+        reclaim(node);
+        throw;
+    }
+
+    node->next = head.load(std::memory_order_relaxed);
+    while (!head.compare_exchange_strong(node->next, node, std::memory_order_release,
+                                         std::memory_order_relaxed))
+    {
+        if (eliminationSize && eliminatePush(node))
+            return;
+        node->next = head.load(std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+std::optional<T> LockFreeStack<T>::try_pop()
+{
+    HazardPointer hp;
+    Node *node;
+    for (;;)
+    {
+        node = hp.protect(head);
+        if (!node)
+            return std::nullopt;
+        // 'node' is protected, so node->next is readable and 'node' can't
+        // be recycled and pushed again before the CAS.
+        if (head.compare_exchange_strong(node, node->next, std::memory_order_acquire,
+                                         std::memory_order_relaxed))
+            break;
+        if (eliminationSize)
+        {
+            if (Node *offered = eliminatePop())
+                return take(offered);
+        }
+    }
+    hp.clear();
+    std::optional<T> result(std::move(*node->value()));
+    node->value()->~T();
+    retire(node, &LockFreeStack::reclaim);
+    return result;
+}
+
+// Moves the value out of a node no other thread can reach and frees it.
+template <typename T>
+std::optional<T> LockFreeStack<T>::take(Node *node)
+{
+    std::optional<T> result(std::move(*node->value()));
+    node->value()->~T();
+    reclaim(node);
+    return result;
+}
+
+template <typename T>
+void LockFreeStack<T>::pause() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+// Offers 'node' in a slot for a while; true if a popper took it.
+template <typename T>
+bool LockFreeStack<T>::eliminatePush(Node *node) noexcept
+{
+    EliminationSlot &slot = randomSlot();
+    Node *expected = nullptr;
+    if (!slot.offer.compare_exchange_strong(expected, node, std::memory_order_release,
+                                            std::memory_order_relaxed))
+        return false;
+    for (int i = 0; i < eliminationSpins; ++i)
+    {
+        if (slot.offer.load(std::memory_order_acquire) != node)
+            return true;
+        pause();
+    }
+    expected = node;
+    // Withdrawing fails only if a popper got there first.
+    return !slot.offer.compare_exchange_strong(expected, nullptr, std::memory_order_acquire,
+                                               std::memory_order_acquire);
+}
+
+// A node offered by a concurrent push, or nullptr. The node never reached
+// the stack, so nobody else can hold a hazard on it.
+template <typename T>
+typename LockFreeStack<T>::Node *LockFreeStack<T>::eliminatePop() noexcept
+{
+    EliminationSlot &slot = randomSlot();
+    for (int i = 0; i < eliminationSpins; ++i)
+    {
+        Node *offered = slot.offer.load(std::memory_order_acquire);
+        if (offered && slot.offer.compare_exchange_strong(offered, nullptr, std::memory_order_acquire,
+                                                          std::memory_order_relaxed))
+            return offered;
+        pause();
+    }
+    return nullptr;
+}
+
+template <typename T>
+typename LockFreeStack<T>::EliminationSlot &LockFreeStack<T>::randomSlot() noexcept
+{
+    // xorshift32, per thread
+    thread_local uint32_t state = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&state)) | 1;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return elimination[state % eliminationSize];
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "LockFreeStack.hpp"
+
+class LockFreeStackTest : public ::testing::Test {
+protected:
+    LockFreeStack<std::string> stack;
+};
+
+// Items come back in LIFO order
+TEST_F(LockFreeStackTest, PushPop) {
+    stack.push("1");
+    stack.push("2");
+    stack.push("3");
+
+    EXPECT_EQ(stack.try_pop(), std::string("3"));
+    EXPECT_EQ(stack.try_pop(), std::string("2"));
+    EXPECT_EQ(stack.try_pop(), std::string("1"));
+}
+
+// Popping an empty stack returns an empty optional instead of throwing
+TEST_F(LockFreeStackTest, PopEmpty) {
+    EXPECT_TRUE(stack.empty());
+    EXPECT_FALSE(stack.try_pop().has_value());
+
+    stack.push("10");
+    EXPECT_FALSE(stack.empty());
+    EXPECT_TRUE(stack.try_pop().has_value());
+    EXPECT_FALSE(stack.try_pop().has_value());
+}
+
+TEST_F(LockFreeStackTest, Emplace) {
+    stack.emplace(3, 'x');
+    EXPECT_EQ(stack.try_pop(), std::string("xxx"));
+}
+
+namespace {
+
+// Each worker notes where its values get constructed, i.e. which node
+// storage the pool handed it.
+thread_local std::unordered_set<const void*>* nodesSeen = nullptr;
+
+struct Tracked {
+    Tracked() = default;
+    explicit Tracked(int value) : value(value) {
+        if (nodesSeen)
+            nodesSeen->insert(this);
+    }
+
+    int value = 0;
+};
+
+} // namespace
+
+// The ABA pattern: pop A, pop B, push A back, so A returns to the top with
+// a different successor. With the pool handing popped storage straight back
+// out, every CAS on the head races nodes whose addresses come and go; none
+// of them may succeed on a stale successor, which would lose or duplicate
+// values.
+TEST(LockFreeStackRecycling, PopPopPushBack) {
+    constexpr int threads = 4;
+    constexpr int rounds = 200000;
+    constexpr int values = 3;
+    LockFreeStack<Tracked> stack;
+    for (int v = 0; v < values; ++v)
+        stack.emplace(v);
+
+    std::vector<std::unordered_set<const void*>> seen(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            nodesSeen = &seen[t];
+            for (int i = 0; i < rounds; ++i) {
+                auto a = stack.try_pop();
+                auto b = stack.try_pop();
+                if (a)
+                    stack.emplace(a->value);
+                if (b)
+                    stack.emplace(b->value);
+            }
+            nodesSeen = nullptr;
+        });
+    }
+    for (auto& w : workers)
+        w.join();
+
+    std::vector<int> count(values, 0);
+    while (auto item = stack.try_pop()) {
+        ASSERT_GE(item->value, 0);
+        ASSERT_LT(item->value, values);
+        ++count[item->value];
+    }
+    for (int c : count)
+        EXPECT_EQ(c, 1);
+
+    // The nodes really were recycled: a few hundred addresses at most for
+    // hundreds of thousands of pushes.
+    std::unordered_set<const void*> nodes;
+    for (auto& s : seen)
+        nodes.insert(s.begin(), s.end());
+    EXPECT_LT(nodes.size(), 1000u);
+}
+
+// Pushers and poppers kept apart meet in the elimination array: every value
+// handed over there, or through the head, is popped exactly once.
+TEST(LockFreeStackElimination, HandsOffExactlyOnce) {
+    constexpr int pushers = 2;
+    constexpr int poppers = 2;
+    constexpr int count = 20000;
+    LockFreeStack<int> stack(2);
+    std::vector<std::atomic<int>> seen(pushers * count);
+    std::atomic<int> popped{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < pushers; ++p) {
+        threads.emplace_back([&, p]() {
+            for (int i = 0; i < count; ++i)
+                stack.push(p * count + i);
+        });
+    }
+    for (int c = 0; c < poppers; ++c) {
+        threads.emplace_back([&]() {
+            while (popped.load() < pushers * count) {
+                if (auto v = stack.try_pop()) {
+                    seen[*v].fetch_add(1);
+                    popped.fetch_add(1);
+                }
+            }
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    for (auto& s : seen)
+        ASSERT_EQ(s.load(), 1);
+    EXPECT_TRUE(stack.empty());
+}
+
+// With nobody popping, offers in the elimination array time out and are
+// withdrawn; the values still end up on the stack.
+TEST(LockFreeStackElimination, WithdrawnOffersArePushed) {
+    constexpr int pushers = 4;
+    constexpr int count = 10000;
+    LockFreeStack<int> stack(1);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < pushers; ++p) {
+        threads.emplace_back([&, p]() {
+            for (int i = 0; i < count; ++i)
+                stack.push(p * count + i);
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    std::vector<int> seen(pushers * count, 0);
+    while (auto v = stack.try_pop())
+        ++seen[*v];
+    for (int s : seen)
+        ASSERT_EQ(s, 1);
+}
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Bounded MPMC queue (Vyukov): an array of cells, each with a sequence
+// number that says whose turn the cell is. A producer claims a slot with
+// one CAS on 'tail', a consumer with one CAS on 'head'; neither ever waits
+// for the other unless the cell it wants is still being written or read.
+//
+// Layout policies pick how cells sit in memory:
+//   PaddedCells - one cell per cache line; neighbouring cells touched by
+//                 different threads never share a line, at the cost of
+//                 padding small elements up to 64 bytes.
+//   DenseCells  - sequence and value packed together; smallest footprint,
+//                 best for scans and when the queue is mostly idle.
+//   SplitCells  - sequence numbers and values in two separate arrays, so
+//                 polling the sequences touches 8 of them per line.
+//
+// T must be nothrow move-constructible; copies are made before a slot is
+// claimed.
+
+struct PaddedCells {};
+struct DenseCells {};
+struct SplitCells {};
+
+namespace mpmc_detail {
+
+template <typename T>
+struct Slot
+{
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    T *value() noexcept { return std::launder(reinterpret_cast<T *>(storage)); }
+};
+
+template <typename T, typename Layout>
+class CellArray;
+
+template <typename T>
+class CellArray<T, PaddedCells>
+{
+public:
+    explicit CellArray(size_t n) : cells(new Cell[n]) {}
+    std::atomic<uint64_t> &seq(size_t i) noexcept { return cells[i].seq; }
+    Slot<T> &slot(size_t i) noexcept { return cells[i].slot; }
+
+private:
+    struct alignas(64) Cell
+    {
+        std::atomic<uint64_t> seq;
+        Slot<T> slot;
+    };
+    std::unique_ptr<Cell[]> cells;
+};
+
+template <typename T>
+class CellArray<T, DenseCells>
+{
+public:
+    explicit CellArray(size_t n) : cells(new Cell[n]) {}
+    std::atomic<uint64_t> &seq(size_t i) noexcept { return cells[i].seq; }
+    Slot<T> &slot(size_t i) noexcept { return cells[i].slot; }
+
+private:
+    struct Cell
+    {
+        std::atomic<uint64_t> seq;
+        Slot<T> slot;
+    };
+    std::unique_ptr<Cell[]> cells;
+};
+
+template <typename T>
+class CellArray<T, SplitCells>
+{
+public:
+    explicit CellArray(size_t n) : seqs(new std::atomic<uint64_t>[n]), slots(new Slot<T>[n]) {}
+    std::atomic<uint64_t> &seq(size_t i) noexcept { return seqs[i]; }
+    Slot<T> &slot(size_t i) noexcept { return slots[i]; }
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> seqs;
+    std::unique_ptr<Slot<T>[]> slots;
+};
+
+} // namespace mpmc_detail
+
+template <typename T, typename Layout = PaddedCells>
+class MPMCBoundedQueue
+{
+    static_assert(std::is_nothrow_move_constructible<T>::value,
+                  "MPMCBoundedQueue needs a nothrow move constructor");
+
+public:
+    // 'capacity' is rounded up to a power of two.
+    explicit MPMCBoundedQueue(size_t capacity);
+    ~MPMCBoundedQueue();
+
+    MPMCBoundedQueue(const MPMCBoundedQueue &) = delete;
+    MPMCBoundedQueue &operator=(const MPMCBoundedQueue &) = delete;
+
+    // False if the queue is full; the item is then left untouched.
+    bool enqueue(const T &item) noexcept(std::is_nothrow_copy_constructible<T>::value) { return emplace(item); }
+    bool enqueue(T &&item) noexcept { return emplace(std::move(item)); }
+
+    template <typename... Args>
+    bool emplace(Args &&...args) noexcept(std::is_nothrow_constructible<T, Args &&...>::value);
+
+    // False if the queue is empty.
+    bool dequeue(T &item) noexcept(std::is_nothrow_move_assignable<T>::value);
+
+    size_t capacity() const noexcept { return capacity_; }
+
+    // Lifetime totals, read from the cursors; approximate under concurrency.
+    uint64_t enqueued() const noexcept { return tail.load(std::memory_order_relaxed); }
+    uint64_t dequeued() const noexcept { return head.load(std::memory_order_relaxed); }
+    size_t size_approx() const noexcept
+    {
+        uint64_t h = dequeued(), t = enqueued();
+        return t > h ? static_cast<size_t>(t - h) : 0;
+    }
+
+private:
+    static size_t roundUpPow2(size_t x)
+    {
+        size_t n = 2;
+        while (n < x)
+            n <<= 1;
+        return n;
+    }
+
+    const size_t capacity_;
+    const size_t mask;
+    mpmc_detail::CellArray<T, Layout> cells;
+    alignas(64) std::atomic<uint64_t> head{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+    char pad[64 - sizeof(std::atomic<uint64_t>)];
+};
+
+template <typename T, typename Layout>
+MPMCBoundedQueue<T, Layout>::MPMCBoundedQueue(size_t capacity)
+    : capacity_(roundUpPow2(capacity)), mask(capacity_ - 1), cells(capacity_)
+{
+    for (size_t i = 0; i < capacity_; ++i)
+        cells.seq(i).store(i, std::memory_order_relaxed);
+}
+
+template <typename T, typename Layout>
+MPMCBoundedQueue<T, Layout>::~MPMCBoundedQueue()
+{
+    for (uint64_t i = dequeued(); i != enqueued(); ++i)
+        cells.slot(i & mask).value()->~T();
+}
+
+template <typename T, typename Layout>
+template <typename... Args>
+bool MPMCBoundedQueue<T, Layout>::emplace(Args &&...args) noexcept(std::is_nothrow_constructible<T, Args &&...>::value)
+{
+    if constexpr (!std::is_nothrow_constructible<T, Args &&...>::value)
+    {
+        T item(std::forward<Args>(args)...);
+        return emplace(std::move(item));
+    }
+    else
+    {
+        uint64_t pos = tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            uint64_t seq = cells.seq(pos & mask).load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if (dif == 0)
+            {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (dif < 0)
+            {
+                return false; // full
+            }
+            else
+            {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+        new (cells.slot(pos & mask).storage) T(std::forward<Args>(args)...);
+        cells.seq(pos & mask).store(pos + 1, std::memory_order_release);
+        return true;
+    }
+}
+
+template <typename T, typename Layout>
+bool MPMCBoundedQueue<T, Layout>::dequeue(T &item) noexcept(std::is_nothrow_move_assignable<T>::value)
+{
+    uint64_t pos = head.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        uint64_t seq = cells.seq(pos & mask).load(std::memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (dif == 0)
+        {
+            if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (dif < 0)
+        {
+            return false; // empty
+        }
+        else
+        {
+            pos = head.load(std::memory_order_relaxed);
+        }
+    }
+    T *value = cells.slot(pos & mask).value();
+    item = std::move(*value);
+    value->~T();
+    cells.seq(pos & mask).store(pos + mask + 1, std::memory_order_release);
+    return true;
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MPMCBoundedQueue.hpp"
+
+constexpr size_t queue_capacity = 4;
+
+// Every test runs once per cell layout.
+template <typename Layout>
+class MPMCBoundedQueueTest : public ::testing::Test {
+protected:
+    MPMCBoundedQueueTest() : queue(queue_capacity) {}
+
+    MPMCBoundedQueue<std::string, Layout> queue;
+};
+
+using Layouts = ::testing::Types<PaddedCells, DenseCells, SplitCells>;
+TYPED_TEST_SUITE(MPMCBoundedQueueTest, Layouts);
+
+// Capacity is usable in full; the next enqueue fails
+TYPED_TEST(MPMCBoundedQueueTest, Enqueue) {
+    EXPECT_TRUE(this->queue.enqueue("1"));
+    EXPECT_TRUE(this->queue.enqueue("2"));
+    EXPECT_TRUE(this->queue.enqueue("3"));
+    EXPECT_TRUE(this->queue.enqueue("4"));
+
+    EXPECT_FALSE(this->queue.enqueue("5"));
+    EXPECT_EQ(this->queue.size_approx(), 4u);
+}
+
+TYPED_TEST(MPMCBoundedQueueTest, Dequeue) {
+    std::string item;
+    this->queue.enqueue("10");
+    this->queue.enqueue("20");
+
+    EXPECT_TRUE(this->queue.dequeue(item));
+    EXPECT_EQ(item, std::string("10"));
+    EXPECT_TRUE(this->queue.dequeue(item));
+    EXPECT_EQ(item, std::string("20"));
+
+    // Dequeue from an empty queue should return false
+    EXPECT_FALSE(this->queue.dequeue(item));
+}
+
+// Wrapping around the ring several times keeps FIFO order
+TYPED_TEST(MPMCBoundedQueueTest, WrapAround) {
+    std::string item;
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_TRUE(this->queue.enqueue(std::to_string(i)));
+        EXPECT_TRUE(this->queue.emplace(2, 'a' + i % 26));
+        EXPECT_TRUE(this->queue.dequeue(item));
+        EXPECT_EQ(item, std::to_string(i));
+        EXPECT_TRUE(this->queue.dequeue(item));
+        EXPECT_EQ(item, std::string(2, 'a' + i % 26));
+    }
+    EXPECT_EQ(this->queue.enqueued(), 40u);
+    EXPECT_EQ(this->queue.dequeued(), 40u);
+}
+
+// A failed enqueue leaves a moved-from argument intact
+TYPED_TEST(MPMCBoundedQueueTest, FullKeepsItem) {
+    for (int i = 0; i < 4; ++i)
+        this->queue.enqueue("x");
+    std::string kept("keep me");
+    EXPECT_FALSE(this->queue.enqueue(std::move(kept)));
+    EXPECT_EQ(kept, std::string("keep me"));
+}
+
+TYPED_TEST(MPMCBoundedQueueTest, MoveOnly) {
+    MPMCBoundedQueue<std::unique_ptr<int>, TypeParam> queue(2);
+    EXPECT_TRUE(queue.enqueue(std::make_unique<int>(3)));
+    std::unique_ptr<int> item;
+    EXPECT_TRUE(queue.dequeue(item));
+    EXPECT_EQ(*item, 3);
+}
+
+// Values still queued are destroyed with the queue
+TYPED_TEST(MPMCBoundedQueueTest, DestroysRemaining) {
+    auto counter = std::make_shared<int>(0);
+    {
+        MPMCBoundedQueue<std::shared_ptr<int>, TypeParam> queue(8);
+        for (int i = 0; i < 5; ++i)
+            queue.enqueue(counter);
+        EXPECT_EQ(counter.use_count(), 6);
+    }
+    EXPECT_EQ(counter.use_count(), 1);
+}
+
+// Two producers and two consumers: every item arrives exactly once
+TYPED_TEST(MPMCBoundedQueueTest, ProducersConsumersParallel) {
+    constexpr int count = 20000;
+    MPMCBoundedQueue<int, TypeParam> queue(64);
+    std::vector<std::atomic<int>> seen(2 * count);
+    std::atomic<int> dequeued{0};
+    std::vector<std::thread> threads;
+    for (int p = 0; p < 2; ++p) {
+        threads.emplace_back([&, p]() {
+            for (int i = 0; i < count; ++i) {
+                while (!queue.enqueue(p * count + i)) {
+                    // Retry until the item is enqueued
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0; c < 2; ++c) {
+        threads.emplace_back([&]() {
+            int item;
+            while (dequeued.load() < 2 * count) {
+                if (queue.dequeue(item)) {
+                    seen[item].fetch_add(1);
+                    dequeued.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+    for (auto& s : seen)
+        ASSERT_EQ(s.load(), 1);
+}
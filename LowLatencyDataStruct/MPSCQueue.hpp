@@ -0,0 +1,275 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Multi-producer single-consumer queues, for many threads feeding one event
+// loop. With a single consumer the dequeue side needs no CAS at all.
+//
+// IntrusiveMPSCQueue (Vyukov): an unbounded linked list threaded through
+// the caller's own nodes. enqueue is one exchange plus one store, so it is
+// wait-free and never allocates.
+//
+// BoundedMPSCQueue: a ring of sequenced cells like MPMCBoundedQueue, but
+// the consumer owns 'head' outright and just stores it.
+//
+// Both let the consumer take a batch per call with dequeue_bulk().
+
+// Base for nodes of an IntrusiveMPSCQueue. A node may sit in one queue at a
+// time; once dequeued the queue no longer touches it.
+struct MPSCHook
+{
+    std::atomic<MPSCHook *> mpscNext{nullptr};
+};
+
+template <typename T>
+class IntrusiveMPSCQueue
+{
+public:
+    IntrusiveMPSCQueue();
+
+    IntrusiveMPSCQueue(const IntrusiveMPSCQueue<T> &) = delete;
+    IntrusiveMPSCQueue &operator=(const IntrusiveMPSCQueue<T> &) = delete;
+
+    // Any thread. The queue doesn't own 'node'; keep it alive until it has
+    // been dequeued.
+    void enqueue(T *node) noexcept { link(node); }
+
+    // Consumer only. nullptr if the queue is empty, or if the only pending
+    // producer has swapped 'tail' but not linked its node yet; that node
+    // shows up on a later call.
+    T *dequeue() noexcept;
+
+    // Consumer only. Dequeues up to 'max' nodes into 'out'; returns how many.
+    size_t dequeue_bulk(T **out, size_t max) noexcept;
+
+    // Consumer only.
+    bool empty() const noexcept;
+
+private:
+    static_assert(std::is_base_of<MPSCHook, T>::value, "IntrusiveMPSCQueue nodes must derive from MPSCHook");
+
+    void link(MPSCHook *node) noexcept;
+
+    alignas(64) std::atomic<MPSCHook *> tail; // producers
+    alignas(64) MPSCHook *head;               // consumer
+    MPSCHook stub;
+};
+
+template <typename T>
+IntrusiveMPSCQueue<T>::IntrusiveMPSCQueue() : tail(&stub), head(&stub)
+{
+}
+
+template <typename T>
+void IntrusiveMPSCQueue<T>::link(MPSCHook *node) noexcept
+{
+    node->mpscNext.store(nullptr, std::memory_order_relaxed);
+    MPSCHook *prev = tail.exchange(node, std::memory_order_acq_rel);
+    // Until this store the list is cut between 'prev' and 'node'.
+    prev->mpscNext.store(node, std::memory_order_release);
+}
+
+template <typename T>
+T *IntrusiveMPSCQueue<T>::dequeue() noexcept
+{
+    MPSCHook *first = head;
+    MPSCHook *next = first->mpscNext.load(std::memory_order_acquire);
+    if (first == &stub)
+    {
+        if (!next)
+            return nullptr;
+        head = next;
+        first = next;
+        next = next->mpscNext.load(std::memory_order_acquire);
+    }
+    if (next)
+    {
+        head = next;
+        return static_cast<T *>(first);
+    }
+    // 'first' is the last linked node. Handing it out would leave nothing to
+    // hang later nodes on, so put the stub behind it first.
+    if (first != tail.load(std::memory_order_acquire))
+        return nullptr; // a producer is between exchange and link
+    link(&stub);
+    next = first->mpscNext.load(std::memory_order_acquire);
+    if (next)
+    {
+        head = next;
+        return static_cast<T *>(first);
+    }
+    return nullptr;
+}
+
+template <typename T>
+size_t IntrusiveMPSCQueue<T>::dequeue_bulk(T **out, size_t max) noexcept
+{
+    size_t n = 0;
+    while (n < max)
+    {
+        T *node = dequeue();
+        if (!node)
+            break;
+        out[n++] = node;
+    }
+    return n;
+}
+
+template <typename T>
+bool IntrusiveMPSCQueue<T>::empty() const noexcept
+{
+    return head->mpscNext.load(std::memory_order_acquire) == nullptr &&
+           tail.load(std::memory_order_acquire) == head;
+}
+
+template <typename T>
+class BoundedMPSCQueue
+{
+    static_assert(std::is_nothrow_move_constructible<T>::value,
+                  "BoundedMPSCQueue needs a nothrow move constructor");
+
+public:
+    // 'capacity' is rounded up to a power of two.
+    explicit BoundedMPSCQueue(size_t capacity);
+    ~BoundedMPSCQueue();
+
+    BoundedMPSCQueue(const BoundedMPSCQueue &) = delete;
+    BoundedMPSCQueue &operator=(const BoundedMPSCQueue &) = delete;
+
+    // Any thread. False if the queue is full; the item is then left untouched.
+    bool enqueue(const T &item) noexcept(std::is_nothrow_copy_constructible<T>::value) { return emplace(item); }
+    bool enqueue(T &&item) noexcept { return emplace(std::move(item)); }
+
+    template <typename... Args>
+    bool emplace(Args &&...args) noexcept(std::is_nothrow_constructible<T, Args &&...>::value);
+
+    // Consumer only. False if the queue is empty.
+    bool dequeue(T &item) noexcept(std::is_nothrow_move_assignable<T>::value);
+
+    // Consumer only. Moves up to 'max' ready items into 'out' and publishes
+    // 'head' once for the whole batch; returns how many.
+    size_t dequeue_bulk(T *out, size_t max) noexcept(std::is_nothrow_move_assignable<T>::value);
+
+    size_t capacity() const noexcept { return capacity_; }
+    size_t size_approx() const noexcept
+    {
+        uint64_t h = head.load(std::memory_order_relaxed), t = tail.load(std::memory_order_relaxed);
+        return t > h ? static_cast<size_t>(t - h) : 0;
+    }
+
+private:
+    struct alignas(64) Cell
+    {
+        std::atomic<uint64_t> seq;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T *value() noexcept { return std::launder(reinterpret_cast<T *>(storage)); }
+    };
+
+    static size_t roundUpPow2(size_t x)
+    {
+        size_t n = 2;
+        while (n < x)
+            n <<= 1;
+        return n;
+    }
+
+    // Moves the item at 'pos' out and hands the cell back to producers.
+    void take(uint64_t pos, T &item) noexcept(std::is_nothrow_move_assignable<T>::value);
+
+    const size_t capacity_;
+    const size_t mask;
+    std::unique_ptr<Cell[]> cells;
+    alignas(64) std::atomic<uint64_t> tail{0}; // producers
+    alignas(64) std::atomic<uint64_t> head{0}; // written by the consumer only
+    char pad[64 - sizeof(std::atomic<uint64_t>)];
+};
+
+template <typename T>
+BoundedMPSCQueue<T>::BoundedMPSCQueue(size_t capacity)
+    : capacity_(roundUpPow2(capacity)), mask(capacity_ - 1), cells(new Cell[capacity_])
+{
+    for (size_t i = 0; i < capacity_; ++i)
+        cells[i].seq.store(i, std::memory_order_relaxed);
+}
+
+template <typename T>
+BoundedMPSCQueue<T>::~BoundedMPSCQueue()
+{
+    for (uint64_t i = head.load(std::memory_order_relaxed); i != tail.load(std::memory_order_relaxed); ++i)
+        cells[i & mask].value()->~T();
+}
+
+template <typename T>
+template <typename... Args>
+bool BoundedMPSCQueue<T>::emplace(Args &&...args) noexcept(std::is_nothrow_constructible<T, Args &&...>::value)
+{
+    if constexpr (!std::is_nothrow_constructible<T, Args &&...>::value)
+    {
+        T item(std::forward<Args>(args)...);
+        return emplace(std::move(item));
+    }
+    else
+    {
+        uint64_t pos = tail.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            uint64_t seq = cells[pos & mask].seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if (dif == 0)
+            {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (dif < 0)
+            {
+                return false; // full
+            }
+            else
+            {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+        new (cells[pos & mask].storage) T(std::forward<Args>(args)...);
+        cells[pos & mask].seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+}
+
+template <typename T>
+void BoundedMPSCQueue<T>::take(uint64_t pos, T &item) noexcept(std::is_nothrow_move_assignable<T>::value)
+{
+    Cell &cell = cells[pos & mask];
+    item = std::move(*cell.value());
+    cell.value()->~T();
+    cell.seq.store(pos + capacity_, std::memory_order_release);
+}
+
+template <typename T>
+bool BoundedMPSCQueue<T>::dequeue(T &item) noexcept(std::is_nothrow_move_assignable<T>::value)
+{
+    uint64_t pos = head.load(std::memory_order_relaxed);
+    if (cells[pos & mask].seq.load(std::memory_order_acquire) != pos + 1)
+        return false; // empty, or the next producer hasn't finished writing
+    take(pos, item);
+    head.store(pos + 1, std::memory_order_relaxed);
+    return true;
+}
+
+template <typename T>
+size_t BoundedMPSCQueue<T>::dequeue_bulk(T *out, size_t max) noexcept(std::is_nothrow_move_assignable<T>::value)
+{
+    uint64_t pos = head.load(std::memory_order_relaxed);
+    size_t n = 0;
+    // Stop at the first cell not yet published, even if later ones are.
+    while (n < max && cells[pos & mask].seq.load(std::memory_order_acquire) == pos + 1)
+        take(pos++, out[n++]);
+    head.store(pos, std::memory_order_relaxed);
+    return n;
+}
@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MPSCQueue.hpp"
+
+struct Event : MPSCHook {
+    explicit Event(int id = 0) : id(id) {}
+    int id;
+};
+
+// Nodes come out in FIFO order and can be enqueued again afterwards
+TEST(IntrusiveMPSCQueueTest, EnqueueDequeue) {
+    IntrusiveMPSCQueue<Event> queue;
+    Event a(1), b(2);
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.dequeue(), nullptr);
+
+    queue.enqueue(&a);
+    queue.enqueue(&b);
+    EXPECT_FALSE(queue.empty());
+    EXPECT_EQ(queue.dequeue(), &a);
+    EXPECT_EQ(queue.dequeue(), &b);
+    EXPECT_EQ(queue.dequeue(), nullptr);
+    EXPECT_TRUE(queue.empty());
+
+    queue.enqueue(&b);
+    queue.enqueue(&a);
+    EXPECT_EQ(queue.dequeue(), &b);
+    EXPECT_EQ(queue.dequeue(), &a);
+    EXPECT_EQ(queue.dequeue(), nullptr);
+}
+
+TEST(IntrusiveMPSCQueueTest, DequeueBulk) {
+    IntrusiveMPSCQueue<Event> queue;
+    std::vector<Event> events(10);
+    for (int i = 0; i < 10; ++i) {
+        events[i].id = i;
+        queue.enqueue(&events[i]);
+    }
+
+    Event* out[4];
+    EXPECT_EQ(queue.dequeue_bulk(out, 4), 4u);
+    EXPECT_EQ(out[0]->id, 0);
+    EXPECT_EQ(out[3]->id, 3);
+    EXPECT_EQ(queue.dequeue_bulk(out, 4), 4u);
+    EXPECT_EQ(out[0]->id, 4);
+    EXPECT_EQ(queue.dequeue_bulk(out, 4), 2u);
+    EXPECT_EQ(out[1]->id, 9);
+    EXPECT_EQ(queue.dequeue_bulk(out, 4), 0u);
+}
+
+// Several producers, one consumer: every node arrives exactly once and each
+// producer's nodes in the order they were sent
+TEST(IntrusiveMPSCQueueTest, ProducersParallel) {
+    constexpr int producers = 4;
+    constexpr int count = 20000;
+    IntrusiveMPSCQueue<Event> queue;
+    std::vector<Event> events(producers * count);
+    for (int i = 0; i < producers * count; ++i)
+        events[i].id = i;
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p]() {
+            for (int i = 0; i < count; ++i)
+                queue.enqueue(&events[p * count + i]);
+        });
+    }
+
+    std::vector<int> seen(producers * count, 0);
+    std::vector<int> last(producers, -1);
+    bool ordered = true;
+    int received = 0;
+    Event* batch[32];
+    while (received < producers * count) {
+        size_t n = queue.dequeue_bulk(batch, 32);
+        if (n == 0)
+            std::this_thread::yield();
+        for (size_t i = 0; i < n; ++i) {
+            int id = batch[i]->id;
+            if (id % count <= last[id / count])
+                ordered = false;
+            last[id / count] = id % count;
+            ++seen[id];
+        }
+        received += static_cast<int>(n);
+    }
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT_TRUE(ordered);
+    for (int s : seen)
+        ASSERT_EQ(s, 1);
+    EXPECT_TRUE(queue.empty());
+}
+
+// Leaves the queue as a producer does between its exchange on 'tail' and
+// its link: 'node' is the tail but 'prev', the node before it, doesn't
+// point at it yet. Returns the link the producer still has to store.
+static MPSCHook* enqueueUnlinked(IntrusiveMPSCQueue<Event>& queue, Event* node, Event* prev) {
+    queue.enqueue(node);
+    prev->mpscNext.store(nullptr);
+    return node;
+}
+
+// The consumer stops at the cut rather than hand out the node before it,
+// which would leave the late producer nothing to link to; once the link
+// lands everything comes out in order.
+TEST(IntrusiveMPSCQueueTest, ProducerBetweenExchangeAndLink) {
+    IntrusiveMPSCQueue<Event> queue;
+    Event a(1), b(2), c(3);
+    queue.enqueue(&a);
+    MPSCHook* pending = enqueueUnlinked(queue, &b, &a);
+
+    EXPECT_EQ(queue.dequeue(), nullptr);
+    EXPECT_FALSE(queue.empty());
+    // Producers after the stalled one link behind it as usual
+    queue.enqueue(&c);
+    EXPECT_EQ(queue.dequeue(), nullptr);
+
+    a.mpscNext.store(pending);
+    EXPECT_EQ(queue.dequeue(), &a);
+    EXPECT_EQ(queue.dequeue(), &b);
+    EXPECT_EQ(queue.dequeue(), &c);
+    EXPECT_EQ(queue.dequeue(), nullptr);
+    EXPECT_TRUE(queue.empty());
+}
+
+// A batch ends at the cut and the next one picks up after the link
+TEST(IntrusiveMPSCQueueTest, DequeueBulkStopsAtCut) {
+    IntrusiveMPSCQueue<Event> queue;
+    std::vector<Event> events(6);
+    for (int i = 0; i < 6; ++i)
+        events[i].id = i;
+    for (int i = 0; i < 3; ++i)
+        queue.enqueue(&events[i]);
+    MPSCHook* pending = enqueueUnlinked(queue, &events[3], &events[2]);
+    queue.enqueue(&events[4]);
+    queue.enqueue(&events[5]);
+
+    Event* out[8];
+    ASSERT_EQ(queue.dequeue_bulk(out, 8), 2u);
+    EXPECT_EQ(out[0]->id, 0);
+    EXPECT_EQ(out[1]->id, 1);
+    EXPECT_EQ(queue.dequeue_bulk(out, 8), 0u);
+
+    events[2].mpscNext.store(pending);
+    ASSERT_EQ(queue.dequeue_bulk(out, 8), 4u);
+    for (int i = 0; i < 4; ++i)
+        EXPECT_EQ(out[i]->id, 2 + i);
+    EXPECT_TRUE(queue.empty());
+}
+
+constexpr size_t queue_capacity = 4;
+
+class BoundedMPSCQueueTest : public ::testing::Test {
+protected:
+    BoundedMPSCQueueTest() : queue(queue_capacity) {}
+
+    BoundedMPSCQueue<std::string> queue;
+};
+
+// Capacity is usable in full; the next enqueue fails
+TEST_F(BoundedMPSCQueueTest, Enqueue) {
+    EXPECT_TRUE(queue.enqueue("1"));
+    EXPECT_TRUE(queue.enqueue("2"));
+    EXPECT_TRUE(queue.enqueue("3"));
+    EXPECT_TRUE(queue.enqueue("4"));
+
+    EXPECT_FALSE(queue.enqueue("5"));
+    EXPECT_EQ(queue.size_approx(), 4u);
+}
+
+TEST_F(BoundedMPSCQueueTest, Dequeue) {
+    std::string item;
+    queue.enqueue("10");
+    queue.emplace(2, 'z');
+
+    EXPECT_TRUE(queue.dequeue(item));
+    EXPECT_EQ(item, std::string("10"));
+    EXPECT_TRUE(queue.dequeue(item));
+    EXPECT_EQ(item, std::string("zz"));
+
+    // Dequeue from an empty queue should return false
+    EXPECT_FALSE(queue.dequeue(item));
+}
+
+// Bulk dequeue frees the whole batch for producers, across the wrap
+TEST_F(BoundedMPSCQueueTest, DequeueBulk) {
+    std::string out[4];
+    for (int round = 0; round < 5; ++round) {
+        for (int i = 0; i < 3; ++i)
+            EXPECT_TRUE(queue.enqueue(std::to_string(round * 3 + i)));
+        EXPECT_EQ(queue.dequeue_bulk(out, 4), 3u);
+        EXPECT_EQ(out[0], std::to_string(round * 3));
+        EXPECT_EQ(out[2], std::to_string(round * 3 + 2));
+    }
+    EXPECT_EQ(queue.dequeue_bulk(out, 4), 0u);
+    EXPECT_EQ(queue.size_approx(), 0u);
+}
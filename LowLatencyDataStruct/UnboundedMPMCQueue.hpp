@@ -0,0 +1,165 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include "HazardPointer.hpp"
+
+// Michael-Scott lock-free unbounded MPMC queue.
+//
+// A linked list with a dummy node at the head: enqueue links a node after
+// the last one with one CAS and then swings 'tail' (any thread that finds
+// 'tail' lagging helps swing it); dequeue swings 'head' to the first real
+// node, which becomes the new dummy, and takes its value.
+//
+// Nodes come from NodePool and dequeued dummies are retired through hazard
+// pointers (slots 0 and 1), so no thread reads a recycled node and the
+// CASes can't suffer ABA. Once warmed up the queue doesn't allocate.
+//
+// Never full; for traffic where dropping or blocking on a bound is not an
+// option. Use LockFreeQueue for SPSC and a bounded ring where a bound is
+// fine, they are cheaper.
+template <typename T>
+class UnboundedMPMCQueue
+{
+public:
+    UnboundedMPMCQueue();
+    ~UnboundedMPMCQueue();
+
+    UnboundedMPMCQueue(const UnboundedMPMCQueue<T> &) = delete;
+    UnboundedMPMCQueue &operator=(const UnboundedMPMCQueue<T> &) = delete;
+
+    void enqueue(const T &item) { emplace(item); }
+    void enqueue(T &&item) { emplace(std::move(item)); }
+
+    template <typename... Args>
+    void emplace(Args &&...args);
+
+    // False if the queue is empty.
+    bool dequeue(T &item);
+
+    bool empty() const;
+
+private:
+    struct Node
+    {
+        std::atomic<Node *> next{nullptr};
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T *value() noexcept { return std::launder(reinterpret_cast<T *>(storage)); }
+    };
+
+    static Node *allocateNode() { return new (NodePool<Node>::instance().allocate()) Node; }
+    static void reclaim(void *p) { NodePool<Node>::instance().deallocate(p); }
+
+    alignas(64) std::atomic<Node *> head;
+    alignas(64) std::atomic<Node *> tail;
+};
+
+template <typename T>
+UnboundedMPMCQueue<T>::UnboundedMPMCQueue()
+{
+    Node *dummy = allocateNode();
+    head.store(dummy, std::memory_order_relaxed);
+    tail.store(dummy, std::memory_order_relaxed);
+}
+
+template <typename T>
+UnboundedMPMCQueue<T>::~UnboundedMPMCQueue()
+{
+    Node *node = head.load(std::memory_order_relaxed);
+    // The dummy holds no value; every node after it does.
+    Node *next = node->next.load(std::memory_order_relaxed);
+    reclaim(node);
+    while (next)
+    {
+        node = next;
+        next = node->next.load(std::memory_order_relaxed);
+        node->value()->~T();
+        reclaim(node);
+    }
+}
+
+template <typename T>
+template <typename... Args>
+void UnboundedMPMCQueue<T>::emplace(Args &&...args)
+{
+    Node *node = allocateNode();
+    try
+    {
+        new (node->storage) T(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+        reclaim(node);
+        throw;
+    }
+
+    HazardPointer hp;
+    for (;;)
+    {
+        Node *last = hp.protect(tail);
+        Node *next = last->next.load(std::memory_order_acquire);
+        if (last != tail.load(std::memory_order_acquire))
+            continue;
+        if (next)
+        {
+            // Tail is lagging behind another enqueue; help it along.
+            tail.compare_exchange_weak(last, next, std::memory_order_release, std::memory_order_relaxed);
+            continue;
+        }
+        Node *expected = nullptr;
+        if (last->next.compare_exchange_weak(expected, node, std::memory_order_release,
+                                             std::memory_order_relaxed))
+        {
+            tail.compare_exchange_strong(last, node, std::memory_order_release, std::memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+template <typename T>
+bool UnboundedMPMCQueue<T>::dequeue(T &item)
+{
+    HazardPointer hpHead(0);
+    HazardPointer hpNext(1);
+    for (;;)
+    {
+        Node *first = hpHead.protect(head);
+        Node *next = hpNext.protect(first->next);
+        // 'first' may have been dequeued while we protected 'next'; if it is
+        // still the head, 'next' is still linked and therefore not retired.
+        if (first != head.load(std::memory_order_acquire))
+            continue;
+        if (!next)
+            return false;
+        Node *last = tail.load(std::memory_order_acquire);
+        if (first == last)
+        {
+            // Don't let head overtake a lagging tail.
+            tail.compare_exchange_weak(last, next, std::memory_order_release, std::memory_order_relaxed);
+            continue;
+        }
+        if (head.compare_exchange_weak(first, next, std::memory_order_acq_rel, std::memory_order_relaxed))
+        {
+            // 'next' is the new dummy; only the winner of the CAS reads its
+            // value and hpNext keeps it alive meanwhile.
+            item = std::move(*next->value());
+            next->value()->~T();
+            hpHead.clear();
+            hpNext.clear();
+            retire(first, &UnboundedMPMCQueue::reclaim);
+            return true;
+        }
+    }
+}
+
+template <typename T>
+bool UnboundedMPMCQueue<T>::empty() const
+{
+    HazardPointer hp;
+    Node *first = hp.protect(head);
+    return first->next.load(std::memory_order_acquire) == nullptr;
+}
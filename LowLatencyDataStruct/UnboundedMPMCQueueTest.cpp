@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "UnboundedMPMCQueue.hpp"
+
+class UnboundedMPMCQueueTest : public ::testing::Test {
+protected:
+    UnboundedMPMCQueue<std::string> queue;
+};
+
+// Items come out in FIFO order
+TEST_F(UnboundedMPMCQueueTest, EnqueueDequeue) {
+    std::string item;
+    queue.enqueue("10");
+    queue.enqueue("20");
+
+    EXPECT_TRUE(queue.dequeue(item));
+    EXPECT_EQ(item, std::string("10"));
+    EXPECT_TRUE(queue.dequeue(item));
+    EXPECT_EQ(item, std::string("20"));
+
+    // Dequeue from an empty queue should return false
+    EXPECT_FALSE(queue.dequeue(item));
+    EXPECT_TRUE(queue.empty());
+}
+
+// There is no capacity: enqueue always succeeds
+TEST_F(UnboundedMPMCQueueTest, Unbounded) {
+    constexpr int count = 100000;
+    for (int i = 0; i < count; ++i)
+        queue.enqueue(std::to_string(i));
+
+    std::string item;
+    for (int i = 0; i < count; ++i) {
+        ASSERT_TRUE(queue.dequeue(item));
+        ASSERT_EQ(item, std::to_string(i));
+    }
+    EXPECT_FALSE(queue.dequeue(item));
+}
+
+TEST_F(UnboundedMPMCQueueTest, Emplace) {
+    std::string item;
+    queue.emplace(2, 'y');
+    EXPECT_TRUE(queue.dequeue(item));
+    EXPECT_EQ(item, std::string("yy"));
+}
+
+namespace {
+
+// Notes where the queue constructs each value, which is inside its node, and
+// can hold a consumer up while it moves a value out of its node.
+std::vector<const void*> built;
+std::atomic<bool> stallNextTake{false}, stalled{false}, resume{false};
+std::atomic<const void*> held{nullptr};
+
+struct Slot {
+    Slot() = default;
+    explicit Slot(int value) : value(value) { built.push_back(this); }
+
+    Slot& operator=(Slot&& other) noexcept {
+        value = other.value;
+        if (stallNextTake.exchange(false)) {
+            held = &other;
+            stalled = true;
+            while (!resume)
+                std::this_thread::yield();
+        }
+        return *this;
+    }
+
+    int value = 0;
+};
+
+bool wasBuiltAt(const void* p) {
+    return std::find(built.begin(), built.end(), p) != built.end();
+}
+
+} // namespace
+
+// A consumer still reading the node it dequeued keeps that node out of the
+// pool, however many nodes other threads retire meanwhile, so nobody can
+// link it into the queue again under it (ABA). Once it is done the node is
+// recycled.
+TEST(UnboundedMPMCQueueRecycling, HeldNodeIsNotReused) {
+    UnboundedMPMCQueue<Slot> queue;
+    queue.emplace(0);
+    queue.emplace(1);
+
+    stallNextTake = true;
+    std::thread consumer([&]() {
+        Slot item;
+        EXPECT_TRUE(queue.dequeue(item));
+        EXPECT_EQ(item.value, 0);
+    });
+    while (!stalled)
+        std::this_thread::yield();
+
+    // Dequeuing 1 retires the held node, and each round one more; that is
+    // enough retirements for many hazard scans.
+    built.clear();
+    Slot item;
+    for (int i = 0; i < 1000; ++i) {
+        queue.emplace(i);
+        ASSERT_TRUE(queue.dequeue(item));
+    }
+    EXPECT_FALSE(wasBuiltAt(held.load()));
+
+    resume = true;
+    consumer.join();
+    for (int i = 0; i < 1000 && !wasBuiltAt(held.load()); ++i) {
+        queue.emplace(i);
+        ASSERT_TRUE(queue.dequeue(item));
+    }
+    EXPECT_TRUE(wasBuiltAt(held.load()));
+}
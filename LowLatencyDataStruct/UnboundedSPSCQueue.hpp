@@ -0,0 +1,147 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+#include "LockFreeQueue.hpp"
+
+// Unbounded single-producer single-consumer queue: a chain of LockFreeQueue
+// ring segments. The producer fills the last segment and, when it is full,
+// links a fresh one behind it; the consumer drains the first segment and,
+// once the producer has moved on, hands it back.
+//
+// Drained segments go to a spare list (itself a LockFreeQueue<Segment *>,
+// consumer to producer), so once the queue has reached its working depth
+// enqueue never allocates. Beyond 'maxSpareSegments' spares the consumer
+// frees them instead, so a one-off backlog doesn't pin its memory.
+//
+// While a segment isn't full the cost is LockFreeQueue's plus one branch.
+// T has the requirements of LockFreeQueue.
+template <typename T>
+class UnboundedSPSCQueue
+{
+public:
+    // 'segmentCapacity' is rounded up to a power of two; a segment holds one
+    // item less. 'maxSpareSegments' is rounded up to a power of two less one.
+    explicit UnboundedSPSCQueue(size_t segmentCapacity = 1024, size_t maxSpareSegments = 15);
+    ~UnboundedSPSCQueue();
+
+    UnboundedSPSCQueue(const UnboundedSPSCQueue<T> &) = delete;
+    UnboundedSPSCQueue &operator=(const UnboundedSPSCQueue<T> &) = delete;
+
+    // Producer only. Never fails.
+    void enqueue(const T &item);
+    void enqueue(T &&item);
+
+    // Consumer only. False if the queue is empty.
+    bool dequeue(T &item) noexcept;
+
+    // Segments currently allocated, in use or spare.
+    size_t segments() const noexcept { return segmentCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Segment
+    {
+        explicit Segment(size_t capacity) : ring(capacity) {}
+
+        LockFreeQueue<T> ring;
+        std::atomic<Segment *> next{nullptr};
+    };
+
+    static size_t roundUpPow2(size_t x)
+    {
+        size_t n = 2;
+        while (n < x)
+            n <<= 1;
+        return n;
+    }
+
+    // Producer: 'tail' is full; moves it to a spare or new segment.
+    void grow();
+
+    const size_t segmentCapacity;
+    LockFreeQueue<Segment *> spare;
+    std::atomic<size_t> segmentCount{0};
+    alignas(64) Segment *tail; // producer
+    alignas(64) Segment *head; // consumer
+};
+
+template <typename T>
+UnboundedSPSCQueue<T>::UnboundedSPSCQueue(size_t segmentCapacity, size_t maxSpareSegments)
+    : segmentCapacity(roundUpPow2(segmentCapacity)), spare(roundUpPow2(maxSpareSegments + 1))
+{
+    tail = head = new Segment(this->segmentCapacity);
+    segmentCount.store(1, std::memory_order_relaxed);
+}
+
+template <typename T>
+UnboundedSPSCQueue<T>::~UnboundedSPSCQueue()
+{
+    Segment *seg = head;
+    while (seg)
+    {
+        Segment *next = seg->next.load(std::memory_order_relaxed);
+        delete seg;
+        seg = next;
+    }
+    while (spare.dequeue(seg))
+        delete seg;
+}
+
+template <typename T>
+void UnboundedSPSCQueue<T>::grow()
+{
+    Segment *seg;
+    if (spare.dequeue(seg))
+    {
+        seg->next.store(nullptr, std::memory_order_relaxed);
+    }
+    else
+    {
+        seg = new Segment(segmentCapacity);
+        segmentCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    tail->next.store(seg, std::memory_order_release);
+    tail = seg;
+}
+
+template <typename T>
+void UnboundedSPSCQueue<T>::enqueue(const T &item)
+{
+    if (tail->ring.enqueue(item))
+        return;
+    grow();
+    tail->ring.enqueue(item);
+}
+
+template <typename T>
+void UnboundedSPSCQueue<T>::enqueue(T &&item)
+{
+    if (tail->ring.enqueue(std::move(item)))
+        return;
+    grow();
+    tail->ring.enqueue(std::move(item));
+}
+
+template <typename T>
+bool UnboundedSPSCQueue<T>::dequeue(T &item) noexcept
+{
+    if (head->ring.dequeue(item))
+        return true;
+    Segment *next = head->next.load(std::memory_order_acquire);
+    if (!next)
+        return false;
+    // The producer finished with 'head' before linking 'next'; anything it
+    // put there is visible now.
+    if (head->ring.dequeue(item))
+        return true;
+    Segment *drained = head;
+    head = next;
+    if (!spare.enqueue(drained))
+    {
+        delete drained;
+        segmentCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return head->ring.dequeue(item);
+}
@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "UnboundedSPSCQueue.hpp"
+
+constexpr size_t segment_capacity = 4;
+
+class UnboundedSPSCQueueTest : public ::testing::Test {
+protected:
+    UnboundedSPSCQueueTest() : queue(segment_capacity, 3) {}
+
+    UnboundedSPSCQueue<std::string> queue;
+};
+
+TEST_F(UnboundedSPSCQueueTest, EnqueueDequeue) {
+    std::string item;
+    queue.enqueue("10");
+    queue.enqueue("20");
+
+    EXPECT_TRUE(queue.dequeue(item));
+    EXPECT_EQ(item, std::string("10"));
+    EXPECT_TRUE(queue.dequeue(item));
+    EXPECT_EQ(item, std::string("20"));
+
+    // Dequeue from an empty queue should return false
+    EXPECT_FALSE(queue.dequeue(item));
+}
+
+// Enqueue never fails; items stay in order across segment boundaries
+TEST_F(UnboundedSPSCQueueTest, Grows) {
+    constexpr int count = 1000;
+    for (int i = 0; i < count; ++i)
+        queue.enqueue(std::to_string(i));
+    EXPECT_GT(queue.segments(), 1u);
+
+    std::string item;
+    for (int i = 0; i < count; ++i) {
+        ASSERT_TRUE(queue.dequeue(item));
+        ASSERT_EQ(item, std::to_string(i));
+    }
+    EXPECT_FALSE(queue.dequeue(item));
+}
+
+// Once warmed up to its working depth the queue reuses its segments
+TEST_F(UnboundedSPSCQueueTest, ReusesSegments) {
+    std::string item;
+    for (int i = 0; i < 6; ++i)
+        queue.enqueue("warm");
+    while (queue.dequeue(item)) {
+    }
+    size_t warmed = queue.segments();
+
+    for (int round = 0; round < 100; ++round) {
+        for (int i = 0; i < 6; ++i)
+            queue.enqueue(std::to_string(i));
+        for (int i = 0; i < 6; ++i) {
+            ASSERT_TRUE(queue.dequeue(item));
+            ASSERT_EQ(item, std::to_string(i));
+        }
+    }
+    EXPECT_EQ(queue.segments(), warmed);
+}
+
+// Spares beyond the limit are freed after a backlog drains
+TEST_F(UnboundedSPSCQueueTest, TrimsSpares) {
+    std::string item;
+    for (int i = 0; i < 100; ++i)
+        queue.enqueue("backlog");
+    size_t peak = queue.segments();
+    while (queue.dequeue(item)) {
+    }
+    EXPECT_LT(queue.segments(), peak);
+    EXPECT_LE(queue.segments(), 1u + 3u);
+}
+
+namespace {
+
+// Holds the producer at one of two points of growing the queue: inside
+// grow(), while a new segment's slots are constructed and before it is
+// linked, or just after, while the item that didn't fit is written to the
+// new segment.
+std::atomic<bool> stallInGrow{false}, stallInWrite{false};
+std::atomic<int> stalledAt{0}, released{0};
+
+void hold(int point) {
+    stalledAt = point;
+    while (released.load() < point)
+        std::this_thread::yield();
+}
+
+struct Step {
+    Step() {
+        if (stallInGrow.exchange(false))
+            hold(1);
+    }
+    explicit Step(int value) : value(value) {}
+    Step(const Step&) = default;
+    Step& operator=(const Step&) = default;
+    Step& operator=(Step&& other) noexcept {
+        value = other.value;
+        if (stallInWrite.exchange(false))
+            hold(2);
+        return *this;
+    }
+
+    int value = 0;
+};
+
+void waitStalledAt(int point) {
+    while (stalledAt.load() != point)
+        std::this_thread::yield();
+}
+
+} // namespace
+
+// The consumer drains a full segment while the producer is growing the
+// queue: before the new segment is linked it must keep its segment, after
+// it must hand the drained one over even though the new one is still
+// empty, and the producer must then reuse it rather than allocate
+TEST(UnboundedSPSCQueueHandoff, WhileProducerGrows) {
+    UnboundedSPSCQueue<Step> queue(segment_capacity, 3);
+    Step item;
+    stallInGrow = true;
+    std::thread producer([&]() {
+        for (int i = 0; i < 9; ++i)
+            queue.enqueue(Step(i));
+    });
+
+    waitStalledAt(1);
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(queue.dequeue(item));
+        EXPECT_EQ(item.value, i);
+    }
+    EXPECT_FALSE(queue.dequeue(item));
+    EXPECT_EQ(queue.segments(), 1u);
+
+    stallInWrite = true;
+    released = 1;
+    waitStalledAt(2);
+    EXPECT_FALSE(queue.dequeue(item));
+    EXPECT_FALSE(queue.dequeue(item));
+
+    released = 2;
+    producer.join();
+    // Items 6 to 8 went to the first segment, taken back from the spares
+    EXPECT_EQ(queue.segments(), 2u);
+    for (int i = 3; i < 9; ++i) {
+        ASSERT_TRUE(queue.dequeue(item));
+        EXPECT_EQ(item.value, i);
+    }
+    EXPECT_FALSE(queue.dequeue(item));
+}
+
+// One item per segment: every enqueue grows the queue and every dequeue
+// hands a segment back while the producer keeps growing on another thread
+TEST(UnboundedSPSCQueueHandoff, EveryItemCrossesSegments) {
+    constexpr int count = 100000;
+    UnboundedSPSCQueue<int> queue(2, 3);
+
+    std::thread producer([&]() {
+        for (int i = 0; i < count; ++i)
+            queue.enqueue(i);
+    });
+
+    int item;
+    for (int i = 0; i < count; ++i) {
+        while (!queue.dequeue(item))
+            std::this_thread::yield();
+        ASSERT_EQ(item, i);
+    }
+    producer.join();
+    EXPECT_FALSE(queue.dequeue(item));
+    EXPECT_LE(queue.segments(), 1u + 3u + 1u);
+}